@@ -0,0 +1,213 @@
+#pragma once
+
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+#include "IOutput.h"
+#include "FixedBufferStreambuf.h"
+#include "FatalSignalFlush.h"
+
+// Условие сброса буфера BufferedConsoleOutput в файловый дескриптор.
+struct FlushPolicy
+{
+  enum class Kind
+  {
+    EveryBulk, // после каждого блока, как ConsoleOutput
+    Bytes,     // при накоплении value байт
+    Bulks,     // при накоплении value блоков
+    Interval   // раз в value миллисекунд
+  };
+
+  // Наибольший порог для Kind::Bytes: буфер выделяется не меньше порога.
+  static constexpr std::size_t max_bytes = 64 * 1024 * 1024;
+
+  Kind kind{Kind::EveryBulk};
+  std::size_t value{0};
+
+  // Разбирает строку вида "bulk", "bytes:N", "bulks:N" или "ms:T".
+  static FlushPolicy Parse(const std::string& str) {
+    if("bulk" == str) {
+      return FlushPolicy{};
+    }
+    auto delimiter = str.find(':');
+    if(std::string::npos == delimiter
+      || delimiter + 1 == str.size()
+      || std::string::npos != str.find_first_not_of("0123456789", delimiter + 1)) {
+      throw std::invalid_argument("FlushPolicy::Parse. Wrong flush policy.");
+    }
+    FlushPolicy policy;
+    auto kind = str.substr(0, delimiter);
+    if("bytes" == kind) {
+      policy.kind = Kind::Bytes;
+    }
+    else if("bulks" == kind) {
+      policy.kind = Kind::Bulks;
+    }
+    else if("ms" == kind) {
+      policy.kind = Kind::Interval;
+    }
+    else {
+      throw std::invalid_argument("FlushPolicy::Parse. Wrong flush policy.");
+    }
+    policy.value = std::stoull(str.substr(delimiter + 1));
+    if(0 == policy.value
+      || (Kind::Bytes == policy.kind && policy.value > max_bytes)) {
+      throw std::invalid_argument("FlushPolicy::Parse. Wrong flush policy.");
+    }
+    return policy;
+  }
+};
+
+// Выводит блоки в файловый дескриптор через буфер в пользовательском пространстве,
+// сбрасывая его согласно FlushPolicy. Буфер также сбрасывается при разрушении объекта,
+// при вызове exit и при получении сигналов, завершающих процесс (см. SignalSafeBuffer).
+// При exit сбрасывается последний созданный экземпляр.
+//
+// Для FlushPolicy::Kind::Bytes размер буфера увеличивается до порога, иначе буфер
+// сбрасывался бы раньше, при переполнении.
+class BufferedConsoleOutput : public IOutput
+{
+
+public:
+
+  // Буфер регистрируется для сброса при сигналах первым, а поток сброса запускается
+  // последним: если конструктор завершится исключением, не останется ни работающего
+  // потока, ни указателя на объект в Active().
+  explicit BufferedConsoleOutput(FlushPolicy policy = FlushPolicy{},
+                                 int fd = STDOUT_FILENO,
+                                 std::size_t capacity = 1 << 16)
+    : policy{policy},
+      buffer{fd, FlushPolicy::Kind::Bytes == policy.kind ? std::max(capacity, policy.value) : capacity} {
+    if(FlushPolicy::Kind::Interval == policy.kind) {
+      flusher = std::thread{&BufferedConsoleOutput::FlushPeriodically, this};
+    }
+    InstallExitHandler();
+    Active().store(this);
+  }
+
+  BufferedConsoleOutput(const BufferedConsoleOutput&) = delete;
+  BufferedConsoleOutput& operator=(const BufferedConsoleOutput&) = delete;
+
+  ~BufferedConsoleOutput() {
+    auto self = this;
+    Active().compare_exchange_strong(self, nullptr);
+    if(flusher.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock{mutex};
+        is_stopped = true;
+      }
+      stop_condition.notify_one();
+      flusher.join();
+    }
+    try {
+      Flush();
+    }
+    catch(...) {}
+  }
+
+  const char* Name() const override {
+    return "BufferedConsoleOutput";
+  }
+
+  void Output(const std::size_t, const Bulk& data) override {
+    std::lock_guard<std::mutex> lock{mutex};
+    auto size = FormattedBulkSize(data);
+    if(buffer.Size() + size > buffer.Capacity()) {
+      FlushLocked();
+    }
+    if(size > buffer.Capacity()) {
+      std::ostringstream oss;
+      OutputFormattedBulk(oss, data);
+      auto str = oss.str();
+      buffer.WriteDirect(str.data(), str.size());
+      return;
+    }
+
+    FixedBufferStreambuf streambuf{buffer.Tail(), buffer.Capacity() - buffer.Size()};
+    std::ostream out{&streambuf};
+    OutputFormattedBulk(out, data);
+    buffer.Commit(size);
+    ++pending_bulks;
+
+    switch(policy.kind) {
+      case FlushPolicy::Kind::EveryBulk:
+        FlushLocked();
+        break;
+      case FlushPolicy::Kind::Bytes:
+        if(buffer.Size() >= policy.value) {
+          FlushLocked();
+        }
+        break;
+      case FlushPolicy::Kind::Bulks:
+        if(pending_bulks >= policy.value) {
+          FlushLocked();
+        }
+        break;
+      case FlushPolicy::Kind::Interval:
+        break;
+    }
+  }
+
+  void Flush() {
+    std::lock_guard<std::mutex> lock{mutex};
+    FlushLocked();
+  }
+
+private:
+
+  void FlushLocked() {
+    pending_bulks = 0;
+    buffer.Flush();
+  }
+
+  void FlushPeriodically() {
+    std::unique_lock<std::mutex> lock{mutex};
+    while(!is_stopped) {
+      stop_condition.wait_for(lock, std::chrono::milliseconds{policy.value});
+      try {
+        FlushLocked();
+      }
+      catch(...) {}
+    }
+  }
+
+  static void OnExit() {
+    auto self = Active().load();
+    if(self) {
+      try {
+        self->Flush();
+      }
+      catch(...) {}
+    }
+  }
+
+  static void InstallExitHandler() {
+    static bool is_installed{false};
+    if(!is_installed) {
+      is_installed = true;
+      std::atexit(OnExit);
+    }
+  }
+
+  // Получатель, который сбрасывается при выходе. Локальная статическая переменная
+  // не нарушает ODR при включении заголовка в несколько единиц трансляции.
+  static std::atomic<BufferedConsoleOutput*>& Active() {
+    static std::atomic<BufferedConsoleOutput*> active{nullptr};
+    return active;
+  }
+
+  const FlushPolicy policy;
+  SignalSafeBuffer buffer;
+  std::size_t pending_bulks{0};
+  std::mutex mutex;
+  std::condition_variable stop_condition;
+  bool is_stopped{false};
+  std::thread flusher;
+};
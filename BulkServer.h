@@ -0,0 +1,383 @@
+#pragma once
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Storage.h"
+#include "ConnectionStorage.h"
+#include "SynchronizedOutput.h"
+#include "SynchronizedStorage.h"
+#include "CommandProcessor.h"
+#include "Tracer.h"
+
+// Принимает команды от клиентов через UNIX-сокет. Соединения обслуживаются
+// несколькими потоками с общим экземпляром epoll. Каждое соединение разбирается
+// своим CommandProcessor, команды вне фигурных скобок от всех соединений
+// собираются в общие блоки, все блоки выводятся в общие получатели.
+class BulkServer
+{
+public:
+
+  BulkServer(const std::string& socket_path, std::size_t block_size, std::size_t thread_count)
+    : socket_path{socket_path},
+      block_size{block_size},
+      thread_count{thread_count},
+      storage{std::make_shared<Storage>(block_size)},
+      shared_storage{std::make_shared<SynchronizedStorage>(storage)} {
+    if(0 == thread_count) {
+      throw std::invalid_argument("BulkServer::BulkServer. Thread count must be positive.");
+    }
+    sockaddr_un address{};
+    if(socket_path.size() >= sizeof(address.sun_path)) {
+      throw std::invalid_argument("BulkServer::BulkServer. Socket path is too long.");
+    }
+  }
+
+  BulkServer(const BulkServer&) = delete;
+  BulkServer& operator=(const BulkServer&) = delete;
+
+  ~BulkServer() {
+    try {
+      Stop();
+    }
+    catch(...) {}
+  }
+
+  // Получатели должны быть подписаны до вызова Start.
+  void Subscribe(const std::shared_ptr<IOutput>& output) {
+    auto synchronized_output = std::make_shared<SynchronizedOutput>(output);
+    outputs.push_back(synchronized_output);
+    storage->Subscribe(synchronized_output);
+  }
+
+  void Start() {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if(-1 == epoll_fd) {
+      throw std::runtime_error("BulkServer::Start. Can't create epoll instance.");
+    }
+    stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(-1 == stop_fd) {
+      throw std::runtime_error("BulkServer::Start. Can't create event descriptor.");
+    }
+    reserve_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    if(-1 == reserve_fd) {
+      throw std::runtime_error("BulkServer::Start. Can't open reserve descriptor.");
+    }
+    Listen();
+
+    // Событие остановки не сбрасывается, поэтому его получат все потоки.
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = &stop_fd;
+    if(-1 == epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &event)) {
+      throw std::runtime_error("BulkServer::Start. Can't register event descriptor.");
+    }
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.ptr = &listen_fd;
+    if(-1 == epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event)) {
+      throw std::runtime_error("BulkServer::Start. Can't register listening socket.");
+    }
+
+    for(std::size_t i = 0; i < thread_count; ++i) {
+      threads.emplace_back(&BulkServer::Run, this);
+    }
+  }
+
+  // Останавливает потоки, закрывает соединения и выводит накопленный общий блок.
+  void Stop() {
+    if(-1 != stop_fd) {
+      std::uint64_t value{1};
+      if(sizeof(value) != write(stop_fd, &value, sizeof(value))) {
+        throw std::runtime_error("BulkServer::Stop. Can't signal worker threads.");
+      }
+    }
+    for(auto& thread : threads) {
+      thread.join();
+    }
+    threads.clear();
+
+    // Данные, уже принятые ядром, обрабатываются до закрытия соединений.
+    if(-1 != listen_fd) {
+      Accept();
+    }
+    for(auto& connection : connections) {
+      Receive(*connection.second);
+      Finish(*connection.second);
+      close(connection.first);
+    }
+    connections.clear();
+    shared_storage->Flush();
+
+    if(-1 != listen_fd) {
+      close(listen_fd);
+      unlink(socket_path.c_str());
+      listen_fd = -1;
+    }
+    if(-1 != reserve_fd) {
+      close(reserve_fd);
+      reserve_fd = -1;
+    }
+    if(-1 != stop_fd) {
+      close(stop_fd);
+      stop_fd = -1;
+    }
+    if(-1 != epoll_fd) {
+      close(epoll_fd);
+      epoll_fd = -1;
+    }
+  }
+
+private:
+
+  struct Connection
+  {
+    int fd;
+    std::string partial_line;
+    CommandProcessor processor;
+    // CommandProcessor хранит подписчиков через weak_ptr.
+    std::shared_ptr<IStorage> storage;
+  };
+
+  void Listen() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+    RemoveStaleSocket(address);
+
+    auto fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(-1 == fd) {
+      throw std::runtime_error("BulkServer::Listen. Can't create socket.");
+    }
+    if(-1 == bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address))) {
+      close(fd);
+      throw std::runtime_error("BulkServer::Listen. Can't bind socket.");
+    }
+    if(-1 == listen(fd, SOMAXCONN)) {
+      close(fd);
+      unlink(socket_path.c_str());
+      throw std::runtime_error("BulkServer::Listen. Can't listen on socket.");
+    }
+    // Stop удаляет файл сокета, только если он был создан этим сервером.
+    listen_fd = fd;
+  }
+
+  // Удаляет файл сокета, оставшийся от завершившегося сервера. Другие файлы
+  // и сокет, который ещё принимает соединения, не трогаются.
+  void RemoveStaleSocket(const sockaddr_un& address) {
+    struct stat info;
+    if(-1 == lstat(socket_path.c_str(), &info)) {
+      if(ENOENT == errno) {
+        return;
+      }
+      throw std::runtime_error("BulkServer::Listen. Can't check socket path.");
+    }
+    if(!S_ISSOCK(info.st_mode)) {
+      throw std::runtime_error("BulkServer::Listen. Address in use.");
+    }
+
+    auto fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(-1 == fd) {
+      throw std::runtime_error("BulkServer::Listen. Can't create socket.");
+    }
+    auto result = connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    auto error = errno;
+    close(fd);
+    // Если очередь работающего сервера заполнена, connect вернёт EAGAIN.
+    if(-1 != result) {
+      throw std::runtime_error("BulkServer::Listen. Address in use by running server.");
+    }
+    if(ECONNREFUSED != error) {
+      throw std::runtime_error("BulkServer::Listen. Address in use.");
+    }
+    unlink(socket_path.c_str());
+  }
+
+  void Run() {
+    const int max_events = 64;
+    epoll_event events[max_events];
+    for(;;) {
+      auto count = epoll_wait(epoll_fd, events, max_events, -1);
+      if(-1 == count) {
+        if(EINTR == errno) {
+          continue;
+        }
+        return;
+      }
+      for(int i = 0; i < count; ++i) {
+        if(&stop_fd == events[i].data.ptr) {
+          return;
+        }
+        if(&listen_fd == events[i].data.ptr) {
+          Accept();
+        }
+        else {
+          Read(static_cast<Connection*>(events[i].data.ptr));
+        }
+      }
+    }
+  }
+
+  void Accept() {
+    for(;;) {
+      auto fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if(-1 == fd) {
+        if(EINTR == errno || ECONNABORTED == errno) {
+          continue;
+        }
+        if((EMFILE == errno || ENFILE == errno) && Reject()) {
+          continue;
+        }
+        break;
+      }
+
+      auto connection = std::make_unique<Connection>();
+      connection->fd = fd;
+      auto block_storage = std::make_shared<Storage>(block_size);
+      for(const auto& output : outputs) {
+        block_storage->Subscribe(output);
+      }
+      connection->storage = std::make_shared<ConnectionStorage>(shared_storage, block_storage);
+      connection->processor.Subscribe(connection->storage);
+
+      epoll_event event{};
+      event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+      event.data.ptr = connection.get();
+      {
+        std::lock_guard<std::mutex> lock{connections_mutex};
+        connections.emplace(fd, std::move(connection));
+      }
+      epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.ptr = &listen_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, listen_fd, &event);
+  }
+
+  // Принимает и сразу закрывает соединение, когда закончились дескрипторы. Иначе оно
+  // осталось бы в очереди и слушающий сокет немедленно сработал бы снова.
+  // Для этого заранее открыт резервный дескриптор. Accept выполняется одним потоком
+  // за раз, поэтому резервный дескриптор не требует синхронизации.
+  bool Reject() {
+    if(-1 != reserve_fd) {
+      close(reserve_fd);
+      auto fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+      auto error = errno;
+      if(-1 != fd) {
+        close(fd);
+      }
+      reserve_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+      if(-1 != fd) {
+        return true;
+      }
+      if(EMFILE != error && ENFILE != error) {
+        return false;
+      }
+    }
+    else {
+      reserve_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    }
+    // Освободившийся дескриптор заняли другие потоки. Пауза перед повторным
+    // включением слушающего сокета не даёт потоку крутиться вхолостую.
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    return false;
+  }
+
+  // Благодаря EPOLLONESHOT соединение обрабатывается одним потоком за раз.
+  void Read(Connection* connection) {
+    if(!Receive(*connection)) {
+      Close(connection);
+      return;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    event.data.ptr = connection;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+  }
+
+  // Разбирает доступные данные. Возвращает false, если соединение закрыто клиентом
+  // или произошла ошибка.
+  bool Receive(Connection& connection) {
+    char buffer[64 * 1024];
+    // Ограничение числа чтений не даёт одному клиенту занять поток надолго.
+    for(int reads = 0; reads < 16; ++reads) {
+      TRACE_SPAN(span, "ReadSocket", 0);
+      auto result = read(connection.fd, buffer, sizeof(buffer));
+      if(-1 == result) {
+        if(EINTR == errno) {
+          continue;
+        }
+        return EAGAIN == errno || EWOULDBLOCK == errno;
+      }
+      if(0 == result) {
+        return false;
+      }
+      Parse(connection, buffer, result);
+    }
+    return true;
+  }
+
+  void Parse(Connection& connection, const char* data, std::size_t size) {
+    auto end = data + size;
+    for(;;) {
+      auto line_end = static_cast<const char*>(std::memchr(data, '\n', end - data));
+      if(!line_end) {
+        connection.partial_line.append(data, end);
+        return;
+      }
+      connection.partial_line.append(data, line_end);
+      connection.processor.ProcessCommand(connection.partial_line);
+      connection.partial_line.clear();
+      data = line_end + 1;
+    }
+  }
+
+  // Последняя строка без перевода строки обрабатывается, как это делает std::getline.
+  void Finish(Connection& connection) {
+    if(!connection.partial_line.empty()) {
+      connection.processor.ProcessCommand(connection.partial_line);
+      connection.partial_line.clear();
+    }
+    connection.processor.Finish();
+  }
+
+  void Close(Connection* connection) {
+    Finish(*connection);
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection->fd, nullptr);
+    auto fd = connection->fd;
+    std::lock_guard<std::mutex> lock{connections_mutex};
+    connections.erase(fd);
+    close(fd);
+  }
+
+  const std::string socket_path;
+  const std::size_t block_size;
+  const std::size_t thread_count;
+  std::shared_ptr<Storage> storage;
+  std::shared_ptr<IStorage> shared_storage;
+  std::vector<std::shared_ptr<IOutput>> outputs;
+
+  int epoll_fd{-1};
+  int stop_fd{-1};
+  int listen_fd{-1};
+  int reserve_fd{-1};
+  std::vector<std::thread> threads;
+
+  std::mutex connections_mutex;
+  std::unordered_map<int, std::unique_ptr<Connection>> connections;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Участок памяти, в который последовательно записываются тексты команд.
+// Записанные байты больше не изменяются, поэтому участок разделяется всеми
+// Storage без копирования и освобождается вместе с последней ссылающейся командой.
+class CommandChunk
+{
+public:
+
+  explicit CommandChunk(std::size_t capacity)
+    : capacity{capacity}, data{new char[capacity]} {}
+
+  std::size_t GetFreeSize() const {
+    return capacity - size;
+  }
+
+  const char* Append(const char* str, std::size_t str_size) {
+    auto result = data.get() + size;
+    std::memcpy(result, str, str_size);
+    size += str_size;
+    return result;
+  }
+
+private:
+
+  const std::size_t capacity;
+  std::unique_ptr<char[]> data;
+  std::size_t size{0};
+};
+
+// Неизменяемая команда: ссылка на текст внутри CommandChunk.
+class Command
+{
+public:
+
+  Command(std::shared_ptr<const CommandChunk> chunk, const char* data, std::size_t size)
+    : chunk{std::move(chunk)}, ptr{data}, length{size} {}
+
+  // Команда в собственном участке памяти.
+  Command(const char* str)
+    : Command{str, std::strlen(str)} {}
+
+  Command(const std::string& str)
+    : Command{str.data(), str.size()} {}
+
+  const char* data() const {
+    return ptr;
+  }
+
+  std::size_t size() const {
+    return length;
+  }
+
+  std::string str() const {
+    return std::string(ptr, length);
+  }
+
+private:
+
+  Command(const char* str, std::size_t size) {
+    auto own_chunk = std::make_shared<CommandChunk>(size);
+    ptr = own_chunk->Append(str, size);
+    length = size;
+    chunk = std::move(own_chunk);
+  }
+
+  std::shared_ptr<const CommandChunk> chunk;
+  const char* ptr;
+  std::size_t length;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const Command& command) {
+  return out.write(command.data(), command.size());
+}
+
+inline bool operator==(const Command& lhs, const std::string& rhs) {
+  return lhs.size() == rhs.size()
+    && 0 == std::memcmp(lhs.data(), rhs.data(), rhs.size());
+}
+
+using Bulk = std::vector<Command>;
+
+// Размещает команды в общих участках памяти CommandChunk.
+class CommandArena
+{
+public:
+
+  explicit CommandArena(std::size_t chunk_size = 16 * 1024)
+    : chunk_size{chunk_size} {}
+
+  Command Materialize(const std::string& str) {
+    // Длинные команды размещаются отдельно, чтобы не удерживать почти пустой участок.
+    if(str.size() > chunk_size / 4) {
+      return Command{str};
+    }
+    if(!chunk || chunk->GetFreeSize() < str.size()) {
+      chunk = std::make_shared<CommandChunk>(chunk_size);
+    }
+    auto data = chunk->Append(str.data(), str.size());
+    return Command{chunk, data, str.size()};
+  }
+
+private:
+
+  const std::size_t chunk_size;
+  std::shared_ptr<CommandChunk> chunk;
+};
@@ -2,37 +2,61 @@
 
 #include <iostream>
 #include "StorageObservable.h"
+#include "CommandTrace.h"
+#include "Tracer.h"
 
 class CommandProcessor : public StorageObservable
 {
 public:
 
   void Process(std::istream& in) {
-    for(std::string command; std::getline(in, command);) {
-      if("{" == command) {
-        if(0 == open_brace_count++) {
-          BlockStart();
-        }
-        continue;
+    for(std::string command; ReadLine(in, command);) {
+      if(trace) {
+        trace->Write(command);
       }
-      if("}" == command) {
-        if(0 == open_brace_count){
-          BlockEnd();
-        }
-        else if(0 == --open_brace_count) {
-          BlockEnd();
-        }
-        continue;
+      ProcessCommand(command);
+    }
+    Finish();
+  }
+
+  void ProcessCommand(const std::string& command) {
+    if("{" == command) {
+      if(0 == open_brace_count++) {
+        BlockStart();
+      }
+      return;
+    }
+    if("}" == command) {
+      if(0 == open_brace_count){
+        BlockEnd();
+      }
+      else if(0 == --open_brace_count) {
+        BlockEnd();
       }
-      Push(command);
+      return;
     }
+    Push(command);
+  }
+
+  void Finish() {
     if(0 == open_brace_count) {
       Flush();
     }
   }
 
+  // Включает запись всех строк, прочитанных Process, в файл трассы.
+  void Capture(const std::shared_ptr<TraceWriter>& writer) {
+    trace = writer;
+  }
+
 private:
 
+  bool ReadLine(std::istream& in, std::string& command) {
+    TRACE_SPAN(span, "ReadLine", 0);
+    return static_cast<bool>(std::getline(in, command));
+  }
+
   std::size_t open_brace_count{0};
+  std::shared_ptr<TraceWriter> trace;
 
 };
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "FatalSignalFlush.h"
+
+// Формат файла трассы: сигнатура "BULKTRC1", время начала записи в микросекундах
+// от эпохи, затем записи вида <интервал от предыдущей записи в микросекундах>
+// <длина строки> <строка>. Числа кодируются как varint (7 бит на байт).
+constexpr char trace_signature[] = "BULKTRC1";
+constexpr std::size_t trace_signature_size = sizeof(trace_signature) - 1;
+
+// Записывает входные строки с моментами их поступления. Записи копятся в буфере и
+// попадают в файл только целиком. Буфер сбрасывается при переполнении, при разрушении
+// объекта и при сигналах, завершающих процесс. Кроме того, при записи строки буфер
+// сбрасывается, если с прошлого сброса прошло FlushInterval(). Отдельного таймера нет:
+// пока строки не поступают, накопленные записи остаются в буфере.
+class TraceWriter
+{
+
+public:
+
+  explicit TraceWriter(const std::string& filename, std::size_t capacity = 1 << 16)
+    : file{filename},
+      buffer{file.fd, capacity},
+      last{std::chrono::steady_clock::now()},
+      last_flush{last} {
+    char header[trace_signature_size + max_varint_size];
+    std::copy(trace_signature, trace_signature + trace_signature_size, header);
+    auto size = trace_signature_size
+      + EncodeVarint(std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::system_clock::now().time_since_epoch()).count(),
+                     header + trace_signature_size);
+    buffer.Append(header, size);
+  }
+
+  TraceWriter(const TraceWriter&) = delete;
+  TraceWriter& operator=(const TraceWriter&) = delete;
+
+  ~TraceWriter() {
+    try {
+      Flush();
+    }
+    catch(...) {}
+  }
+
+  void Write(const std::string& line) {
+    auto now = std::chrono::steady_clock::now();
+    char header[2 * max_varint_size];
+    auto header_size = EncodeVarint(std::chrono::duration_cast<std::chrono::microseconds>(now - last).count(),
+                                    header);
+    header_size += EncodeVarint(line.size(), header + header_size);
+    auto size = header_size + line.size();
+
+    if(buffer.Size() + size > buffer.Capacity()) {
+      Flush();
+    }
+    if(size > buffer.Capacity()) {
+      buffer.WriteDirect(header, header_size);
+      buffer.WriteDirect(line.data(), line.size());
+    }
+    else {
+      auto tail = buffer.Tail();
+      std::copy(header, header + header_size, tail);
+      std::copy(line.data(), line.data() + line.size(), tail + header_size);
+      buffer.Commit(size);
+    }
+    // Интервал округляется вниз, поэтому точку отсчёта сдвигаем на записанную величину,
+    // чтобы ошибка округления не накапливалась.
+    last += std::chrono::duration_cast<std::chrono::microseconds>(now - last);
+
+    if(now - last_flush >= FlushInterval()) {
+      Flush();
+    }
+  }
+
+  void Flush() {
+    buffer.Flush();
+    last_flush = std::chrono::steady_clock::now();
+  }
+
+private:
+
+  static constexpr std::size_t max_varint_size = 10;
+
+  // Владеет дескриптором файла трассы. Объявлен перед буфером, поэтому дескриптор
+  // закрывается и тогда, когда конструктор буфера завершается исключением.
+  struct TraceFile
+  {
+    explicit TraceFile(const std::string& filename)
+      : fd{open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)} {
+      if(-1 == fd) {
+        throw std::runtime_error("TraceWriter::TraceWriter. Can't open file for output.");
+      }
+    }
+
+    TraceFile(const TraceFile&) = delete;
+    TraceFile& operator=(const TraceFile&) = delete;
+
+    ~TraceFile() {
+      close(fd);
+    }
+
+    const int fd;
+  };
+
+  static std::chrono::milliseconds FlushInterval() {
+    return std::chrono::milliseconds{100};
+  }
+
+  static std::size_t EncodeVarint(std::uint64_t value, char* out) {
+    std::size_t size{0};
+    while(value >= 0x80) {
+      out[size++] = static_cast<char>(value | 0x80);
+      value >>= 7;
+    }
+    out[size++] = static_cast<char>(value);
+    return size;
+  }
+
+  TraceFile file;
+  SignalSafeBuffer buffer;
+  std::chrono::steady_clock::time_point last;
+  std::chrono::steady_clock::time_point last_flush;
+};
+
+// Последовательно читает записи файла трассы.
+class TraceReader
+{
+
+public:
+
+  explicit TraceReader(const std::string& filename)
+    : ifs{filename.c_str(), std::ifstream::in | std::ifstream::binary} {
+    if(ifs.fail()) {
+      throw std::runtime_error("TraceReader::TraceReader. Can't open file for input.");
+    }
+    char signature[trace_signature_size];
+    ifs.read(signature, trace_signature_size);
+    if(ifs.fail()
+      || !std::equal(signature, signature + trace_signature_size, trace_signature)
+      || !ReadVarint(start_timestamp)) {
+      throw std::runtime_error("TraceReader::TraceReader. File has wrong format.");
+    }
+  }
+
+  // Время начала записи трассы в микросекундах от эпохи.
+  std::uint64_t GetStartTimestamp() const {
+    return start_timestamp;
+  }
+
+  // Читает очередную запись. time - время поступления строки в микросекундах
+  // от начала записи трассы. Возвращает false по достижении конца файла.
+  // Оборванная последняя запись (процесс завершился во время записи трассы)
+  // считается концом файла, см. IsTruncated.
+  bool Next(std::uint64_t& time, std::string& line) {
+    std::uint64_t interval;
+    if(!ReadVarint(interval)) {
+      return false;
+    }
+    std::uint64_t size;
+    if(!ReadVarint(size)) {
+      is_truncated = true;
+      return false;
+    }
+    line.resize(size);
+    ifs.read(&line[0], size);
+    if(ifs.fail()) {
+      is_truncated = true;
+      return false;
+    }
+    elapsed += interval;
+    time = elapsed;
+    return true;
+  }
+
+  // Последняя запись файла оборвана и пропущена.
+  bool IsTruncated() const {
+    return is_truncated;
+  }
+
+private:
+
+  // Возвращает false в конце файла. Конец файла внутри числа означает оборванную запись.
+  bool ReadVarint(std::uint64_t& value) {
+    value = 0;
+    for(std::size_t shift = 0; shift < 64; shift += 7) {
+      auto byte = ifs.get();
+      if(std::ifstream::traits_type::eof() == byte) {
+        is_truncated = is_truncated || 0 != shift;
+        return false;
+      }
+      value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+      if(0 == (byte & 0x80)) {
+        return true;
+      }
+    }
+    throw std::runtime_error("TraceReader::ReadVarint. Number is too long.");
+  }
+
+  std::ifstream ifs;
+  std::uint64_t start_timestamp;
+  std::uint64_t elapsed{0};
+  bool is_truncated{false};
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <memory>
+#include "IStorage.h"
+
+// Хранилище одного клиентского соединения. Команды вне фигурных скобок попадают
+// в общее для всех соединений хранилище, динамические блоки накапливаются отдельно.
+class ConnectionStorage : public IStorage
+{
+public:
+
+  ConnectionStorage(const std::shared_ptr<IStorage>& shared_storage,
+                    const std::shared_ptr<IStorage>& block_storage)
+    : shared_storage{shared_storage}, block_storage{block_storage} {}
+
+  void Push(const Command& data) override {
+    if(is_block) {
+      block_storage->Push(data);
+    }
+    else {
+      shared_storage->Push(data);
+    }
+  }
+
+  // Общее хранилище сбрасывается владельцем, а незавершённый динамический блок
+  // при закрытии соединения отбрасывается.
+  void Flush() override {}
+
+  void BlockStart() override {
+    is_block = true;
+    block_storage->BlockStart();
+  }
+
+  void BlockEnd() override {
+    if(is_block) {
+      block_storage->BlockEnd();
+      is_block = false;
+    }
+  }
+
+private:
+
+  std::shared_ptr<IStorage> shared_storage;
+  std::shared_ptr<IStorage> block_storage;
+  bool is_block{false};
+};
@@ -11,7 +11,11 @@ public:
   explicit ConsoleOutput(std::ostream& out)
     : out{out} {}
 
-  void Output(const std::size_t, const std::list<std::string>& data) override {
+  const char* Name() const override {
+    return "ConsoleOutput";
+  }
+
+  void Output(const std::size_t, const Bulk& data) override {
     OutputFormattedBulk(out, data);
   }
 
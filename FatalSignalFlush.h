@@ -0,0 +1,216 @@
+#pragma once
+
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+
+// Буфер, который сбрасывается при сигнале, завершающем процесс. FlushFromSignal
+// вызывается из обработчика сигнала: мьютексы захватывать нельзя, вывод только через write.
+class ISignalFlushable
+{
+public:
+
+  virtual void FlushFromSignal() = 0;
+
+protected:
+
+  ~ISignalFlushable() = default;
+};
+
+// Сбрасывает зарегистрированные буферы при сигналах, завершающих процесс, и затем
+// завершает процесс тем же сигналом. Обработчики устанавливаются при первой регистрации
+// и только для сигналов, которые обрабатываются по умолчанию.
+class FatalSignalFlush
+{
+public:
+
+  static void Register(ISignalFlushable* flushable) {
+    InstallHandlers();
+    for(auto& slot : Slots()) {
+      ISignalFlushable* expected{nullptr};
+      if(slot.compare_exchange_strong(expected, flushable)) {
+        return;
+      }
+    }
+    throw std::runtime_error("FatalSignalFlush::Register. Too many buffers.");
+  }
+
+  static void Unregister(ISignalFlushable* flushable) {
+    for(auto& slot : Slots()) {
+      auto expected = flushable;
+      slot.compare_exchange_strong(expected, nullptr);
+    }
+  }
+
+private:
+
+  static constexpr std::size_t max_count = 8;
+  using SlotArray = std::atomic<ISignalFlushable*>[max_count];
+
+  // Статический массив инициализируется нулями без защиты, поэтому доступен в обработчике.
+  static SlotArray& Slots() {
+    static SlotArray slots;
+    return slots;
+  }
+
+  static void OnFatalSignal(int signal_number) {
+    for(auto& slot : Slots()) {
+      auto flushable = slot.load();
+      if(flushable) {
+        flushable->FlushFromSignal();
+      }
+    }
+    // Обработчик установлен с SA_RESETHAND, повторный сигнал завершит процесс.
+    raise(signal_number);
+  }
+
+  static void InstallHandlers() {
+    static bool is_installed{false};
+    if(is_installed) {
+      return;
+    }
+    is_installed = true;
+
+    for(auto signal_number : {SIGHUP, SIGINT, SIGQUIT, SIGTERM,
+                              SIGILL, SIGABRT, SIGBUS, SIGFPE, SIGSEGV}) {
+      struct sigaction current;
+      if(0 != sigaction(signal_number, nullptr, &current)
+        || SIG_DFL != current.sa_handler) {
+        continue;
+      }
+      struct sigaction action{};
+      action.sa_handler = OnFatalSignal;
+      action.sa_flags = SA_RESETHAND;
+      sigemptyset(&action.sa_mask);
+      sigaction(signal_number, &action, nullptr);
+    }
+  }
+};
+
+// Буфер вывода в файловый дескриптор, который сбрасывается и при сигналах, завершающих
+// процесс. Данные дописываются и сбрасываются одним потоком или под внешним мьютексом,
+// обработчик сигнала может выполняться одновременно с ними в любом потоке.
+//
+// Сброс идёт частями по flush_chunk_size байт, и каждая часть помечается выведенной до
+// вызова write. Обработчик сигнала забирает себе остаток буфера тем же сдвигом begin,
+// после чего сброс прекращается. Поэтому при сигнале во время сброса теряется не больше
+// одной части, повторно данные не выводятся.
+class SignalSafeBuffer : private ISignalFlushable
+{
+
+public:
+
+  static constexpr std::size_t flush_chunk_size = 4096;
+
+  SignalSafeBuffer(int fd, std::size_t capacity)
+    : fd{fd},
+      capacity{capacity},
+      buffer{new char[capacity]} {
+    FatalSignalFlush::Register(this);
+  }
+
+  SignalSafeBuffer(const SignalSafeBuffer&) = delete;
+  SignalSafeBuffer& operator=(const SignalSafeBuffer&) = delete;
+
+  ~SignalSafeBuffer() {
+    FatalSignalFlush::Unregister(this);
+  }
+
+  std::size_t Capacity() const {
+    return capacity;
+  }
+
+  std::size_t Size() const {
+    return end.load(std::memory_order_relaxed);
+  }
+
+  // Свободная часть буфера. Записанные в неё данные становятся частью буфера после Commit.
+  char* Tail() {
+    return buffer.get() + Size();
+  }
+
+  void Commit(std::size_t size) {
+    end.store(Size() + size, std::memory_order_release);
+  }
+
+  void Append(const char* data, std::size_t size) {
+    std::copy(data, data + size, Tail());
+    Commit(size);
+  }
+
+  void Flush() {
+    auto used = end.load(std::memory_order_relaxed);
+    try {
+      for(auto written = begin.load(std::memory_order_relaxed); written < used;) {
+        auto chunk_end = std::min(written + flush_chunk_size, used);
+        if(!begin.compare_exchange_strong(written, chunk_end, std::memory_order_acq_rel)) {
+          // Остаток забрал обработчик сигнала, процесс завершается.
+          return;
+        }
+        WriteDirect(buffer.get() + written, chunk_end - written);
+        written = chunk_end;
+      }
+    }
+    catch(...) {
+      Reset();
+      throw;
+    }
+    Reset();
+  }
+
+  // Выводит данные мимо буфера, например блок, который в буфер не помещается.
+  void WriteDirect(const char* data, std::size_t size) {
+    while(0 != size) {
+      auto result = write(fd, data, size);
+      if(-1 == result) {
+        if(EINTR == errno) {
+          continue;
+        }
+        throw std::runtime_error("SignalSafeBuffer::WriteDirect. Failed to write to file descriptor.");
+      }
+      data += result;
+      size -= result;
+    }
+  }
+
+private:
+
+  void Reset() {
+    // end обнуляется первым: обработчик сигнала читает begin, затем end,
+    // и не должен увидеть старый end вместе с обнулённым begin.
+    end.store(0, std::memory_order_release);
+    begin.store(0, std::memory_order_release);
+  }
+
+  void FlushFromSignal() override {
+    auto written = begin.load(std::memory_order_acquire);
+    std::size_t used;
+    do {
+      used = end.load(std::memory_order_acquire);
+      if(written >= used) {
+        return;
+      }
+    } while(!begin.compare_exchange_weak(written, used, std::memory_order_acq_rel));
+    while(written < used) {
+      auto result = write(fd, buffer.get() + written, used - written);
+      if(-1 == result) {
+        if(EINTR == errno) {
+          continue;
+        }
+        return;
+      }
+      written += result;
+    }
+  }
+
+  const int fd;
+  const std::size_t capacity;
+  std::unique_ptr<char[]> buffer;
+  std::atomic<std::size_t> begin{0};
+  std::atomic<std::size_t> end{0};
+};
@@ -2,6 +2,7 @@
 
 #include <fstream>
 #include "IOutput.h"
+#include "Tracer.h"
 
 std::string MakeFilename(std::size_t timestamp) {
   std::string filename = "bulk" + std::to_string(timestamp) + ".log";
@@ -13,15 +14,29 @@ class FileOutput : public IOutput
 
 public:
 
-  void Output(std::size_t timestamp, const std::list<std::string>& data) override {
+  const char* Name() const override {
+    return "FileOutput";
+  }
+
+  void Output(std::size_t timestamp, const Bulk& data) override {
     auto filename = MakeFilename(timestamp);
-    std::ofstream ofs{filename.c_str(), std::ofstream::out | std::ofstream::trunc};
+    std::ofstream ofs;
+    {
+      TRACE_SPAN(span, "FileOutput::Open", timestamp);
+      ofs.open(filename.c_str(), std::ofstream::out | std::ofstream::trunc);
+    }
     if(ofs.fail()) {
       throw std::runtime_error("FileOutput::Output. Can't open file for output.");
     }
-    OutputFormattedBulk(ofs, data);
+    {
+      TRACE_SPAN(span, "FileOutput::Write", timestamp);
+      OutputFormattedBulk(ofs, data);
+    }
     auto is_failed = ofs.fail();
-    ofs.close();
+    {
+      TRACE_SPAN(span, "FileOutput::Close", timestamp);
+      ofs.close();
+    }
     if(is_failed) {
       throw std::runtime_error("FileOutput::Output. Failed to write to file.");
     }
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <streambuf>
+
+// Буфер потока поверх фиксированного участка памяти. При переполнении поток
+// переходит в состояние ошибки.
+class FixedBufferStreambuf : public std::streambuf
+{
+public:
+
+  FixedBufferStreambuf(char* begin, std::size_t size) {
+    setp(begin, begin + size);
+  }
+
+  std::size_t Size() const {
+    return pptr() - pbase();
+  }
+};
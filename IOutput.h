@@ -1,25 +1,47 @@
 #pragma once
 
 #include <time.h>
-#include <list>
 #include <string>
 #include <sstream>
 #include <algorithm>
+#include "Command.h"
 #include "infix_iterator.h"
 
 class IOutput
 {
 public:
 
-  virtual void Output(const std::size_t timestamp, const std::list<std::string>& data) = 0;
+  // Имя получателя в трассе обработки. Строка должна существовать всё время работы программы.
+  virtual const char* Name() const = 0;
+
+  virtual void Output(const std::size_t timestamp, const Bulk& data) = 0;
+
+  // Вызывается хранилищем. is_dynamic - блок ограничен фигурными скобками, а не размером.
+  // Получатели, которым это важно, переопределяют OutputBulk вместо Output.
+  virtual void OutputBulk(const std::size_t timestamp, const Bulk& data, bool is_dynamic) {
+    (void)is_dynamic;
+    Output(timestamp, data);
+  }
 
 protected:
 
-  void OutputFormattedBulk(std::ostream& out, const std::list<std::string>& data) {
+  void OutputFormattedBulk(std::ostream& out, const Bulk& data) {
     out << "bulk: ";
     std::copy(std::cbegin(data),
               std::cend(data),
-              infix_ostream_iterator<std::string>{out, ", "});
+              infix_ostream_iterator<Command>{out, ", "});
     out << std::endl;
   }
+
+  // Размер результата OutputFormattedBulk в байтах.
+  static std::size_t FormattedBulkSize(const Bulk& data) {
+    std::size_t result = sizeof("bulk: ") - 1 + sizeof('\n');
+    for(const auto& command : data) {
+      result += command.size();
+    }
+    if(!data.empty()) {
+      result += (data.size() - 1) * (sizeof(", ") - 1);
+    }
+    return result;
+  }
 };
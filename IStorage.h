@@ -1,11 +1,11 @@
 #pragma once
 
-#include <string>
+#include "Command.h"
 
 class IStorage
 {
 public:
-  virtual void Push(const std::string& data) = 0;
+  virtual void Push(const Command& data) = 0;
   virtual void Flush() = 0;
   virtual void BlockStart() = 0;
   virtual void BlockEnd() = 0;
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define BULK_JSON_ESCAPE_X86
+#include <immintrin.h>
+#endif
+
+// Экранирование строк для JSON. Экранируются кавычка, обратная косая черта и управляющие
+// символы 0x00-0x1F, остальные байты, включая UTF-8, копируются без изменений.
+// Байты, требующие экранирования, ищутся векторными инструкциями: AVX2, если процессор
+// его поддерживает, иначе SSE2, на других архитектурах - побайтно.
+//
+// Функции WriteJsonEscaped* записывают результат в out и возвращают указатель на его конец.
+// В out должно быть доступно не меньше JsonEscapedMaxSize(size) байт: функции записывают
+// блоки и экранированные символы целиком, до того как узнают, сколько из них войдёт в результат.
+
+inline std::size_t JsonEscapedMaxSize(std::size_t size) {
+  return 6 * size + 32;
+}
+
+inline bool NeedsJsonEscape(unsigned char symbol) {
+  return symbol < 0x20 || '"' == symbol || '\\' == symbol;
+}
+
+// Экранированные записи символов, которым это требуется. Запись дополнена до 8 байт,
+// чтобы копироваться одной инструкцией.
+class JsonEscapeTable
+{
+public:
+
+  JsonEscapeTable() {
+    const char hex[] = "0123456789abcdef";
+    for(unsigned symbol = 0; symbol < 0x20; ++symbol) {
+      Set(symbol, {'\\', 'u', '0', '0', hex[symbol >> 4], hex[symbol & 0xf]});
+    }
+    Set('"', {'\\', '"'});
+    Set('\\', {'\\', '\\'});
+    Set('\b', {'\\', 'b'});
+    Set('\f', {'\\', 'f'});
+    Set('\n', {'\\', 'n'});
+    Set('\r', {'\\', 'r'});
+    Set('\t', {'\\', 't'});
+  }
+
+  const char* Text(unsigned char symbol) const {
+    return text[symbol];
+  }
+
+  std::size_t Size(unsigned char symbol) const {
+    return size[symbol];
+  }
+
+private:
+
+  void Set(unsigned symbol, std::initializer_list<char> escaped) {
+    std::copy(escaped.begin(), escaped.end(), text[symbol]);
+    size[symbol] = escaped.size();
+  }
+
+  static constexpr unsigned table_size = '\\' + 1;
+  char text[table_size][8]{};
+  unsigned char size[table_size]{};
+};
+
+inline const JsonEscapeTable& GetJsonEscapeTable() {
+  static const JsonEscapeTable table;
+  return table;
+}
+
+// symbol должен требовать экранирования. Записывает 8 байт, результат занимает до 6.
+inline char* WriteJsonEscapedSymbol(char* out, unsigned char symbol) {
+  const auto& table = GetJsonEscapeTable();
+  std::memcpy(out, table.Text(symbol), 8);
+  return out + table.Size(symbol);
+}
+
+inline char* WriteJsonEscapedScalar(char* out, const char* data, std::size_t size) {
+  for(std::size_t i = 0; i < size; ++i) {
+    if(NeedsJsonEscape(data[i])) {
+      out = WriteJsonEscapedSymbol(out, data[i]);
+    }
+    else {
+      *out++ = data[i];
+    }
+  }
+  return out;
+}
+
+#ifdef BULK_JSON_ESCAPE_X86
+
+inline char* WriteJsonEscapedSse2(char* out, const char* data, std::size_t size) {
+  const auto quote = _mm_set1_epi8('"');
+  const auto backslash = _mm_set1_epi8('\\');
+  const auto control = _mm_set1_epi8(0x1f);
+  // Копия блока с запасом, чтобы промежутки между экранируемыми байтами
+  // копировались одной записью вектора.
+  alignas(16) char block[32]{};
+  std::size_t i = 0;
+  while(i + 16 <= size) {
+    auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    // max(x, 0x1F) == 0x1F только для x <= 0x1F без учёта знака.
+    auto mask = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                          _mm_cmpeq_epi8(chunk, backslash)),
+                             _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+    auto bits = static_cast<unsigned>(_mm_movemask_epi8(mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), chunk);
+    i += 16;
+    if(0 == bits) {
+      out += 16;
+      continue;
+    }
+    // Каждый промежуток записывается целым вектором, лишние байты перезапишет следующая запись.
+    _mm_store_si128(reinterpret_cast<__m128i*>(block), chunk);
+    unsigned position = 0;
+    do {
+      auto escape = static_cast<unsigned>(__builtin_ctz(bits));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + position)));
+      out = WriteJsonEscapedSymbol(out + escape - position, block[escape]);
+      position = escape + 1;
+      bits &= bits - 1;
+    } while(0 != bits);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                     _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + position)));
+    out += 16 - position;
+  }
+  return WriteJsonEscapedScalar(out, data + i, size - i);
+}
+
+__attribute__((target("avx2")))
+inline char* WriteJsonEscapedAvx2(char* out, const char* data, std::size_t size) {
+  const auto quote = _mm256_set1_epi8('"');
+  const auto backslash = _mm256_set1_epi8('\\');
+  const auto control = _mm256_set1_epi8(0x1f);
+  alignas(32) char block[64]{};
+  std::size_t i = 0;
+  while(i + 32 <= size) {
+    auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    auto mask = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote),
+                                                _mm256_cmpeq_epi8(chunk, backslash)),
+                                _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control), control));
+    auto bits = static_cast<unsigned>(_mm256_movemask_epi8(mask));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), chunk);
+    i += 32;
+    if(0 == bits) {
+      out += 32;
+      continue;
+    }
+    _mm256_store_si256(reinterpret_cast<__m256i*>(block), chunk);
+    unsigned position = 0;
+    do {
+      auto escape = static_cast<unsigned>(__builtin_ctz(bits));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + position)));
+      out = WriteJsonEscapedSymbol(out + escape - position, block[escape]);
+      position = escape + 1;
+      bits &= bits - 1;
+    } while(0 != bits);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + position)));
+    out += 32 - position;
+  }
+  return WriteJsonEscapedSse2(out, data + i, size - i);
+}
+
+#endif
+
+inline char* WriteJsonEscaped(char* out, const char* data, std::size_t size) {
+#ifdef BULK_JSON_ESCAPE_X86
+  // Короткие строки не заполняют ни одного вектора.
+  if(size < 16) {
+    return WriteJsonEscapedScalar(out, data, size);
+  }
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  if(has_avx2) {
+    return WriteJsonEscapedAvx2(out, data, size);
+  }
+  return WriteJsonEscapedSse2(out, data, size);
+#else
+  return WriteJsonEscapedScalar(out, data, size);
+#endif
+}
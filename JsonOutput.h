@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+#include "IOutput.h"
+#include "JsonEscape.h"
+
+// Выводит блоки в формате JSON lines: по одной записи
+// {"ts":<метка времени>,"dynamic":<true|false>,"cmds":[<команды>]} на строку.
+// Запись формируется в буфере, который переиспользуется между блоками, и сбрасывается
+// в поток сразу, чтобы читатели файла получали записи по мере появления.
+class JsonOutput : public IOutput
+{
+
+public:
+
+  explicit JsonOutput(std::ostream& out)
+    : out{out} {}
+
+  const char* Name() const override {
+    return "JsonOutput";
+  }
+
+  void Output(const std::size_t timestamp, const Bulk& data) override {
+    OutputBulk(timestamp, data, false);
+  }
+
+  void OutputBulk(const std::size_t timestamp, const Bulk& data, bool is_dynamic) override {
+    used = 0;
+    Append("{\"ts\":");
+    AppendNumber(timestamp);
+    Append(is_dynamic ? ",\"dynamic\":true,\"cmds\":[" : ",\"dynamic\":false,\"cmds\":[");
+    auto is_first = true;
+    for(const auto& command : data) {
+      Append(is_first ? "\"" : ",\"");
+      Reserve(JsonEscapedMaxSize(command.size()));
+      used = WriteJsonEscaped(buffer.data() + used, command.data(), command.size()) - buffer.data();
+      Append("\"");
+      is_first = false;
+    }
+    Append("]}\n");
+    out.write(buffer.data(), used);
+    out.flush();
+    if(out.fail()) {
+      throw std::runtime_error("JsonOutput::OutputBulk. Failed to write to stream.");
+    }
+  }
+
+private:
+
+  // Буфер только растёт, поэтому в установившемся режиме память не выделяется.
+  void Reserve(std::size_t size) {
+    if(buffer.size() < used + size) {
+      buffer.resize(std::max(2 * buffer.size(), used + size));
+    }
+  }
+
+  void Append(const char* str) {
+    auto size = std::strlen(str);
+    Reserve(size);
+    std::memcpy(buffer.data() + used, str, size);
+    used += size;
+  }
+
+  void AppendNumber(std::size_t value) {
+    char digits[20];
+    auto end = digits + sizeof(digits);
+    auto begin = end;
+    do {
+      *--begin = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while(0 != value);
+    Reserve(end - begin);
+    std::memcpy(buffer.data() + used, begin, end - begin);
+    used += end - begin;
+  }
+
+  std::ostream& out;
+  std::vector<char> buffer;
+  std::size_t used{0};
+};
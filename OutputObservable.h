@@ -2,18 +2,20 @@
 
 #include "IOutput.h"
 #include "Observable.h"
+#include "Tracer.h"
 
 class OutputObservable : public Observable<IOutput>
 {
 
 protected:
 
-  void Output(const std::size_t timestamp, const std::list<std::string>& data) {
+  void Output(const std::size_t timestamp, const Bulk& data, bool is_dynamic) {
     for (const auto& subscriber : subscribers) {
       auto subscriber_locked = subscriber.lock();
       if(subscriber_locked) {
+        TRACE_SPAN(span, subscriber_locked->Name(), timestamp);
         try {
-          subscriber_locked->Output(timestamp, data);
+          subscriber_locked->OutputBulk(timestamp, data, is_dynamic);
         }
         catch(...) {}
       }
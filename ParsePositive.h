@@ -0,0 +1,19 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <string>
+
+// Разбирает положительное десятичное число аргумента командной строки.
+inline unsigned long long ParsePositive(const std::string& digit_str) {
+  if(!std::all_of(std::cbegin(digit_str),
+                  std::cend(digit_str),
+                  [](unsigned char symbol) { return std::isdigit(symbol); } ))
+    throw std::invalid_argument("");
+
+  auto result = std::stoull(digit_str);
+  if(0 == result)
+    throw std::invalid_argument("");
+  return result;
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+#include "IOutput.h"
+#include "FixedBufferStreambuf.h"
+#include "SharedMemoryRing.h"
+
+// Публикует отформатированные блоки в кольцевой буфер в разделяемой памяти POSIX.
+// Один производитель, произвольное количество читателей (см. SharedMemoryReader).
+// Блок, который не помещается в слот, занимает несколько слотов подряд, а блок больше
+// всего буфера обрезается, так что каждый блок продвигает published.
+// Сегмент с тем же именем заменяется, только если его производитель завершился.
+class SharedMemoryOutput : public IOutput
+{
+
+public:
+
+  explicit SharedMemoryOutput(const std::string& name,
+                              std::uint32_t slot_count = 1024,
+                              std::uint32_t slot_size = 4096)
+    : name{name}, size{ShmRingSize(slot_count, slot_size)} {
+    if(0 == slot_count) {
+      throw std::invalid_argument("SharedMemoryOutput::SharedMemoryOutput. Slot count must be positive.");
+    }
+    if(0 == slot_size) {
+      throw std::invalid_argument("SharedMemoryOutput::SharedMemoryOutput. Slot size must be positive.");
+    }
+    auto fd = Create(name);
+    if(-1 == ftruncate(fd, size)) {
+      close(fd);
+      shm_unlink(name.c_str());
+      throw std::runtime_error("SharedMemoryOutput::SharedMemoryOutput. Can't resize shared memory object.");
+    }
+    base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(MAP_FAILED == base) {
+      shm_unlink(name.c_str());
+      throw std::runtime_error("SharedMemoryOutput::SharedMemoryOutput. Can't map shared memory object.");
+    }
+
+    header = new (base) ShmRingHeader{};
+    header->version = shm_ring_version;
+    header->slot_count = slot_count;
+    header->slot_size = slot_size;
+    header->producer_pid = getpid();
+    header->closed.store(0, std::memory_order_relaxed);
+    for(std::uint64_t i = 0; i < slot_count; ++i) {
+      new (ShmRingSlotAt(base, *header, i)) ShmRingSlot{};
+    }
+    header->published.store(0, std::memory_order_relaxed);
+    header->magic.store(shm_ring_magic, std::memory_order_release);
+  }
+
+  SharedMemoryOutput(const SharedMemoryOutput&) = delete;
+  SharedMemoryOutput& operator=(const SharedMemoryOutput&) = delete;
+
+  // Имя освобождается до установки closed, чтобы новый производитель, увидевший closed,
+  // не удалил уже свой сегмент.
+  ~SharedMemoryOutput() {
+    shm_unlink(name.c_str());
+    header->closed.store(1, std::memory_order_release);
+    munmap(base, size);
+  }
+
+  const char* Name() const override {
+    return "SharedMemoryOutput";
+  }
+
+  void Output(const std::size_t timestamp, const Bulk& data) override {
+    auto sequence = header->published.load(std::memory_order_relaxed);
+    auto bulk_size = FormattedBulkSize(data);
+    if(bulk_size <= header->slot_size) {
+      auto slot = BeginSlot(sequence);
+      FixedBufferStreambuf buffer{ShmRingPayload(slot), header->slot_size};
+      std::ostream out{&buffer};
+      OutputFormattedBulk(out, data);
+      EndSlot(slot, sequence, timestamp, buffer.Size(), 0);
+      header->published.store(sequence + 1, std::memory_order_release);
+      return;
+    }
+
+    // Большой блок форматируется отдельно и раскладывается по слотам.
+    large_bulk.resize(bulk_size);
+    FixedBufferStreambuf buffer{large_bulk.data(), bulk_size};
+    std::ostream out{&buffer};
+    OutputFormattedBulk(out, data);
+
+    std::uint32_t flags{0};
+    auto capacity = std::min<std::uint64_t>(std::uint64_t{header->slot_count} * header->slot_size,
+                                            std::numeric_limits<std::uint32_t>::max());
+    if(bulk_size > capacity) {
+      bulk_size = capacity;
+      flags = shm_ring_truncated;
+    }
+    auto slot_count = ShmRingSlotsFor(bulk_size, header->slot_size);
+    for(std::uint64_t i = 0; i < slot_count; ++i) {
+      auto slot = BeginSlot(sequence + i);
+      auto offset = i * header->slot_size;
+      auto part_size = std::min<std::uint64_t>(header->slot_size, bulk_size - offset);
+      std::memcpy(ShmRingPayload(slot), large_bulk.data() + offset, part_size);
+      EndSlot(slot, sequence + i, timestamp,
+              0 == i ? bulk_size : part_size,
+              0 == i ? flags : flags | shm_ring_continuation);
+    }
+    header->published.store(sequence + slot_count, std::memory_order_release);
+  }
+
+private:
+
+  static int Create(const std::string& name) {
+    for(auto is_retry : {false, true}) {
+      auto fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+      if(-1 != fd) {
+        return fd;
+      }
+      if(EEXIST != errno) {
+        break;
+      }
+      if(is_retry || !IsStale(name)) {
+        throw std::runtime_error("SharedMemoryOutput::SharedMemoryOutput. Shared memory object is in use.");
+      }
+      shm_unlink(name.c_str());
+    }
+    throw std::runtime_error("SharedMemoryOutput::SharedMemoryOutput. Can't open shared memory object.");
+  }
+
+  // Сегмент оставлен завершившимся производителем. Сегмент неизвестного формата
+  // или ещё не инициализированный считается используемым.
+  static bool IsStale(const std::string& name) {
+    auto fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if(-1 == fd) {
+      return false;
+    }
+    struct stat info;
+    if(-1 == fstat(fd, &info)
+      || static_cast<std::size_t>(info.st_size) < sizeof(ShmRingHeader)) {
+      close(fd);
+      return false;
+    }
+    auto existing = mmap(nullptr, sizeof(ShmRingHeader), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(MAP_FAILED == existing) {
+      return false;
+    }
+    auto existing_header = static_cast<const ShmRingHeader*>(existing);
+    auto result = shm_ring_magic == existing_header->magic.load(std::memory_order_acquire)
+      && shm_ring_version == existing_header->version
+      && !ShmRingIsProducerAlive(*existing_header);
+    munmap(existing, sizeof(ShmRingHeader));
+    return result;
+  }
+
+  ShmRingSlot* BeginSlot(std::uint64_t sequence) {
+    auto slot = ShmRingSlotAt(base, *header, sequence);
+    slot->sequence.store(2 * sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return slot;
+  }
+
+  void EndSlot(ShmRingSlot* slot, std::uint64_t sequence, std::size_t timestamp,
+               std::size_t size, std::uint32_t flags) {
+    slot->timestamp = timestamp;
+    slot->size = size;
+    slot->flags = flags;
+    slot->sequence.store(2 * sequence + 2, std::memory_order_release);
+  }
+
+  const std::string name;
+  const std::size_t size;
+  void* base;
+  ShmRingHeader* header;
+  std::vector<char> large_bulk;
+};
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+#include "SharedMemoryRing.h"
+
+// Читатель кольцевого буфера, заполняемого SharedMemoryOutput.
+// После подключения TryRead не выполняет системных вызовов.
+class SharedMemoryReader
+{
+
+public:
+
+  // Поведение при обгоне читателя производителем.
+  enum class OverrunPolicy
+  {
+    Throw,        // выбросить исключение
+    SkipToOldest, // продолжить с самого старого блока, оставшегося в буфере
+    SkipToNewest  // пропустить всё и ждать следующий блок
+  };
+
+  explicit SharedMemoryReader(const std::string& name,
+                              OverrunPolicy policy = OverrunPolicy::SkipToOldest)
+    : policy{policy} {
+    auto fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if(-1 == fd) {
+      throw std::runtime_error("SharedMemoryReader::SharedMemoryReader. Can't open shared memory object.");
+    }
+    struct stat info;
+    if(-1 == fstat(fd, &info)
+      || static_cast<std::size_t>(info.st_size) < sizeof(ShmRingHeader)) {
+      close(fd);
+      throw std::runtime_error("SharedMemoryReader::SharedMemoryReader. Shared memory object is too small.");
+    }
+    size = info.st_size;
+    base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(MAP_FAILED == base) {
+      throw std::runtime_error("SharedMemoryReader::SharedMemoryReader. Can't map shared memory object.");
+    }
+
+    header = static_cast<const ShmRingHeader*>(base);
+    if(shm_ring_magic != header->magic.load(std::memory_order_acquire)
+      || shm_ring_version != header->version
+      || 0 == header->slot_count
+      || 0 == header->slot_size
+      || size < ShmRingSize(header->slot_count, header->slot_size)) {
+      munmap(const_cast<void*>(base), size);
+      throw std::runtime_error("SharedMemoryReader::SharedMemoryReader. Shared memory object has wrong format.");
+    }
+    next = header->published.load(std::memory_order_acquire);
+  }
+
+  SharedMemoryReader(const SharedMemoryReader&) = delete;
+  SharedMemoryReader& operator=(const SharedMemoryReader&) = delete;
+
+  ~SharedMemoryReader() {
+    munmap(const_cast<void*>(base), size);
+  }
+
+  // Читает следующий блок. Возвращает false, если новых блоков нет.
+  bool TryRead(std::size_t& timestamp, std::string& bulk) {
+    for(;;) {
+      auto slot = ShmRingSlotAt(base, *header, next);
+      auto sequence = slot->sequence.load(std::memory_order_acquire);
+      if(sequence < 2 * next + 2) {
+        return false;
+      }
+      if(sequence == 2 * next + 2) {
+        auto slot_timestamp = slot->timestamp;
+        auto bulk_size = slot->size;
+        auto flags = slot->flags;
+        auto slot_count = ShmRingSlotsFor(bulk_size, header->slot_size);
+        // Слишком большое значение возможно, только если слот уже перезаписывается.
+        if(slot_count <= header->slot_count) {
+          auto state = ReadSlots(slot_count, bulk_size, bulk);
+          if(SlotsState::Writing == state) {
+            return false;
+          }
+          if(SlotsState::Ready == state) {
+            // Читатель догнал производителя с середины большого блока.
+            if(0 != (flags & shm_ring_continuation)) {
+              ++lost_count;
+              ++next;
+              continue;
+            }
+            if(0 != (flags & shm_ring_truncated)) {
+              ++truncated_count;
+            }
+            timestamp = slot_timestamp;
+            next += slot_count;
+            return true;
+          }
+        }
+      }
+      Resync();
+    }
+  }
+
+  // Количество слотов, пропущенных из-за обгона. Блок больше slot_size занимает
+  // несколько слотов.
+  std::uint64_t GetLostCount() const {
+    return lost_count;
+  }
+
+  // false, если производитель завершился: новых блоков в этом сегменте не будет.
+  // Выполняет системный вызов, поэтому вызывается, когда TryRead вернул false.
+  bool IsProducerAlive() const {
+    return ShmRingIsProducerAlive(*header);
+  }
+
+  // Количество прочитанных блоков, которые были больше всего буфера и обрезаны.
+  std::uint64_t GetTruncatedCount() const {
+    return truncated_count;
+  }
+
+  // Порядковый номер блока, который будет прочитан следующим.
+  std::uint64_t GetNextSequence() const {
+    return next;
+  }
+
+private:
+
+  enum class SlotsState
+  {
+    Ready,    // все слоты блока прочитаны
+    Writing,  // производитель ещё записывает блок
+    Overrun   // слоты перезаписаны следующими блоками
+  };
+
+  // Копирует блок из slot_count слотов, начиная с next, и проверяет, что за время
+  // копирования они не изменились.
+  SlotsState ReadSlots(std::uint64_t slot_count, std::size_t bulk_size, std::string& bulk) {
+    for(std::uint64_t i = 1; i < slot_count; ++i) {
+      auto sequence = ShmRingSlotAt(base, *header, next + i)->sequence.load(std::memory_order_acquire);
+      if(sequence < 2 * (next + i) + 2) {
+        return SlotsState::Writing;
+      }
+      if(sequence > 2 * (next + i) + 2) {
+        return SlotsState::Overrun;
+      }
+    }
+
+    bulk.resize(bulk_size);
+    for(std::uint64_t i = 0; i < slot_count; ++i) {
+      auto offset = i * header->slot_size;
+      auto part_size = std::min<std::uint64_t>(header->slot_size, bulk_size - offset);
+      std::memcpy(&bulk[offset], ShmRingPayload(ShmRingSlotAt(base, *header, next + i)), part_size);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    for(std::uint64_t i = 0; i < slot_count; ++i) {
+      auto sequence = ShmRingSlotAt(base, *header, next + i)->sequence.load(std::memory_order_relaxed);
+      if(2 * (next + i) + 2 != sequence) {
+        return SlotsState::Overrun;
+      }
+    }
+    return SlotsState::Ready;
+  }
+
+  void Resync() {
+    if(OverrunPolicy::Throw == policy) {
+      throw std::runtime_error("SharedMemoryReader::TryRead. Reader was overrun by producer.");
+    }
+    auto published = header->published.load(std::memory_order_acquire);
+    auto resync_to = published;
+    // Слот блока published - slot_count может перезаписываться прямо сейчас.
+    if(OverrunPolicy::SkipToOldest == policy
+      && published >= header->slot_count) {
+      resync_to = published - header->slot_count + 1;
+    }
+    if(resync_to > next) {
+      lost_count += resync_to - next;
+      next = resync_to;
+    }
+    else {
+      // Производитель уже ушёл дальше published, пропускаем хотя бы один блок.
+      ++lost_count;
+      ++next;
+    }
+  }
+
+  const OverrunPolicy policy;
+  std::size_t size;
+  const void* base;
+  const ShmRingHeader* header;
+  std::uint64_t next;
+  std::uint64_t lost_count{0};
+  std::uint64_t truncated_count{0};
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <signal.h>
+#include <errno.h>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+static_assert(2 == ATOMIC_LLONG_LOCK_FREE, "Shared memory ring requires lock free 64 bit atomics.");
+
+constexpr std::uint64_t shm_ring_magic = 0x4b4c5542474e4952; // "RINGBULK"
+constexpr std::uint32_t shm_ring_version = 3;
+constexpr std::size_t shm_ring_alignment = 64;
+
+// Заголовок сегмента. Записывается производителем один раз при создании,
+// magic публикуется последним. closed устанавливается при завершении производителя.
+struct ShmRingHeader
+{
+  std::atomic<std::uint64_t> magic;
+  std::uint32_t version;
+  std::uint32_t slot_count;
+  std::uint32_t slot_size;
+  std::uint32_t producer_pid;
+  std::atomic<std::uint32_t> closed;
+  // Количество опубликованных блоков, он же порядковый номер следующего.
+  alignas(shm_ring_alignment) std::atomic<std::uint64_t> published;
+};
+
+// Производитель работает: сегмент не закрыт и его процесс существует.
+// Выполняет системный вызов, поэтому читатели проверяют это только при простое.
+inline bool ShmRingIsProducerAlive(const ShmRingHeader& header) {
+  if(0 != header.closed.load(std::memory_order_acquire)) {
+    return false;
+  }
+  return 0 == kill(static_cast<pid_t>(header.producer_pid), 0) || EPERM == errno;
+}
+
+// Флаги слота.
+constexpr std::uint32_t shm_ring_continuation = 1; // продолжение блока из предыдущего слота
+constexpr std::uint32_t shm_ring_truncated = 2;    // блок больше всего буфера и обрезан
+
+// Заголовок слота, за ним следует slot_size байт отформатированного блока.
+// sequence равен 2 * seq + 1 во время записи слота с номером seq
+// и 2 * seq + 2 после её завершения, 0 - слот ещё не использовался.
+// Блок больше slot_size занимает несколько слотов подряд, size первого из них
+// равен размеру всего блока.
+struct ShmRingSlot
+{
+  std::atomic<std::uint64_t> sequence;
+  std::uint64_t timestamp;
+  std::uint32_t size;
+  std::uint32_t flags;
+};
+
+// Количество слотов, которое занимает блок размером size.
+inline std::uint64_t ShmRingSlotsFor(std::uint64_t size, std::uint32_t slot_size) {
+  return size <= slot_size ? 1 : (size + slot_size - 1) / slot_size;
+}
+
+inline std::size_t ShmRingAlign(std::size_t size) {
+  return (size + shm_ring_alignment - 1) / shm_ring_alignment * shm_ring_alignment;
+}
+
+inline std::size_t ShmRingSlotStride(std::uint32_t slot_size) {
+  return ShmRingAlign(sizeof(ShmRingSlot) + slot_size);
+}
+
+inline std::size_t ShmRingSize(std::uint32_t slot_count, std::uint32_t slot_size) {
+  return ShmRingAlign(sizeof(ShmRingHeader)) + slot_count * ShmRingSlotStride(slot_size);
+}
+
+inline ShmRingSlot* ShmRingSlotAt(void* base, const ShmRingHeader& header, std::uint64_t sequence) {
+  auto slots = static_cast<char*>(base) + ShmRingAlign(sizeof(ShmRingHeader));
+  return reinterpret_cast<ShmRingSlot*>(slots + (sequence % header.slot_count) * ShmRingSlotStride(header.slot_size));
+}
+
+inline const ShmRingSlot* ShmRingSlotAt(const void* base, const ShmRingHeader& header, std::uint64_t sequence) {
+  return ShmRingSlotAt(const_cast<void*>(base), header, sequence);
+}
+
+inline char* ShmRingPayload(ShmRingSlot* slot) {
+  return reinterpret_cast<char*>(slot + 1);
+}
+
+inline const char* ShmRingPayload(const ShmRingSlot* slot) {
+  return reinterpret_cast<const char*>(slot + 1);
+}
@@ -3,6 +3,7 @@
 #include <chrono>
 #include "IStorage.h"
 #include "OutputObservable.h"
+#include "Tracer.h"
 
 class Storage : public IStorage, public OutputObservable
 {
@@ -12,11 +13,13 @@ public:
     : block_size{block_size}, is_dynamic_size{false} {}
 
 
-  void Push(const std::string& new_data) override {
+  void Push(const Command& new_data) override {
+    TRACE_SPAN(span, "Storage::Push", 0);
     if(data.empty()) {
       timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
                   std::chrono::system_clock::now().time_since_epoch()).count();
     }
+    TRACE_SET_BULK(span, timestamp);
     data.push_back(new_data);
     if(!is_dynamic_size
       && (block_size == data.size())) {
@@ -26,7 +29,8 @@ public:
 
   void Flush() override {
     if(!data.empty()) {
-      Output(timestamp, data);
+      TRACE_SPAN(span, "Storage::Flush", timestamp);
+      Output(timestamp, data, is_dynamic_size);
       data.clear();
     }
   }
@@ -44,6 +48,6 @@ public:
 private:
   const std::size_t block_size;
   bool is_dynamic_size;
-  std::list<std::string> data;
+  Bulk data;
   std::size_t timestamp;
 };
@@ -12,8 +12,10 @@ class StorageObservable : public Observable<IStorage>
 
 protected:
 
+  // Команда размещается в памяти один раз и разделяется всеми подписчиками.
   void Push(const std::string& data) {
-    Notify( [&data] (const std::shared_ptr<IStorage>& subscriber) { subscriber->Push(data); } );
+    auto command = ThreadArena().Materialize(data);
+    Notify( [&command] (const std::shared_ptr<IStorage>& subscriber) { subscriber->Push(command); } );
   }
 
   void Flush() {
@@ -30,6 +32,13 @@ protected:
 
 private:
 
+  // Участки памяти общие для всех обработчиков потока. С собственным участком каждое
+  // соединение сервера удерживало бы его целиком, пока его команды ждут в общем блоке.
+  static CommandArena& ThreadArena() {
+    thread_local CommandArena arena;
+    return arena;
+  }
+
   template<typename Callable>
   void Notify(Callable&& callable) {
      for (const auto& subscriber : subscribers) {
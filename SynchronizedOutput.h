@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include "IOutput.h"
+
+// Сериализует вызовы Output для получателя, к которому обращаются из нескольких потоков.
+class SynchronizedOutput : public IOutput
+{
+
+public:
+
+  explicit SynchronizedOutput(const std::shared_ptr<IOutput>& output)
+    : output{output} {}
+
+  // В трассе вывод помечается именем получателя, а не обёртки.
+  const char* Name() const override {
+    return output->Name();
+  }
+
+  void Output(const std::size_t timestamp, const Bulk& data) override {
+    std::lock_guard<std::mutex> lock{mutex};
+    output->Output(timestamp, data);
+  }
+
+  void OutputBulk(const std::size_t timestamp, const Bulk& data, bool is_dynamic) override {
+    std::lock_guard<std::mutex> lock{mutex};
+    output->OutputBulk(timestamp, data, is_dynamic);
+  }
+
+private:
+
+  std::shared_ptr<IOutput> output;
+  std::mutex mutex;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include "IStorage.h"
+
+// Сериализует обращения к хранилищу, общему для нескольких потоков.
+class SynchronizedStorage : public IStorage
+{
+public:
+
+  explicit SynchronizedStorage(const std::shared_ptr<IStorage>& storage)
+    : storage{storage} {}
+
+  void Push(const Command& data) override {
+    std::lock_guard<std::mutex> lock{mutex};
+    storage->Push(data);
+  }
+
+  void Flush() override {
+    std::lock_guard<std::mutex> lock{mutex};
+    storage->Flush();
+  }
+
+  void BlockStart() override {
+    std::lock_guard<std::mutex> lock{mutex};
+    storage->BlockStart();
+  }
+
+  void BlockEnd() override {
+    std::lock_guard<std::mutex> lock{mutex};
+    storage->BlockEnd();
+  }
+
+private:
+
+  std::shared_ptr<IStorage> storage;
+  std::mutex mutex;
+};
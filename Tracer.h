@@ -0,0 +1,189 @@
+#pragma once
+
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Трассировка этапов обработки блоков. Интервалы записываются в кольцевые буферы
+// потоков и выгружаются в формате Chrome trace event (chrome://tracing, Perfetto).
+// Без определения BULK_TRACING макросы TRACE_* ничего не генерируют, а при сборке
+// с ним, пока трассировка не включена, каждый интервал стоит одного чтения атомарного флага.
+
+struct TraceEvent
+{
+  const char* name;
+  std::uint64_t start;
+  std::uint64_t duration;
+  std::uint64_t bulk;
+};
+
+class Tracer
+{
+public:
+
+#ifdef BULK_TRACING
+  static constexpr bool is_compiled_in = true;
+#else
+  static constexpr bool is_compiled_in = false;
+#endif
+
+  static Tracer& Instance() {
+    static Tracer tracer;
+    return tracer;
+  }
+
+  // capacity - количество последних интервалов, сохраняемых для каждого потока.
+  // Вызывается, когда интервалы не записываются.
+  void Enable(std::size_t capacity = 1 << 16) {
+    std::lock_guard<std::mutex> lock{mutex};
+    buffer_capacity = capacity;
+    for(auto& buffer : buffers) {
+      buffer->Reset(capacity);
+    }
+    is_enabled.store(true, std::memory_order_relaxed);
+  }
+
+  void Disable() {
+    is_enabled.store(false, std::memory_order_relaxed);
+  }
+
+  bool IsEnabled() const {
+    return is_enabled.load(std::memory_order_relaxed);
+  }
+
+  static std::uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  void Record(const char* name, std::uint64_t start, std::uint64_t end, std::uint64_t bulk) {
+    thread_local TraceBuffer* buffer = Register();
+    buffer->Push(TraceEvent{name, start, end - start, bulk});
+  }
+
+  // Выгружает интервалы в формате JSON. Вызывается после остановки обработки.
+  void Dump(std::ostream& out) {
+    std::lock_guard<std::mutex> lock{mutex};
+    auto pid = getpid();
+    auto is_first = true;
+    out << "{\"traceEvents\":[";
+    for(const auto& buffer : buffers) {
+      buffer->ForEach([&] (const TraceEvent& event) {
+        out << (is_first ? "\n" : ",\n")
+            << "{\"name\":\"" << event.name
+            << "\",\"ph\":\"X\",\"pid\":" << pid
+            << ",\"tid\":" << buffer->GetThreadId()
+            << ",\"ts\":" << event.start / 1000 << '.' << Fraction(event.start)
+            << ",\"dur\":" << event.duration / 1000 << '.' << Fraction(event.duration)
+            << ",\"args\":{\"bulk\":" << event.bulk << "}}";
+        is_first = false;
+      });
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\"}" << std::endl;
+  }
+
+private:
+
+  // Кольцевой буфер одного потока, хранит последние capacity интервалов.
+  class TraceBuffer
+  {
+  public:
+
+    TraceBuffer(std::size_t thread_id, std::size_t capacity)
+      : thread_id{thread_id} {
+      Reset(capacity);
+    }
+
+    void Reset(std::size_t capacity) {
+      events.assign(capacity, TraceEvent{});
+      count = 0;
+    }
+
+    void Push(const TraceEvent& event) {
+      if(events.empty()) {
+        return;
+      }
+      events[count % events.size()] = event;
+      ++count;
+    }
+
+    template<typename Callable>
+    void ForEach(Callable&& callable) const {
+      auto first = count > events.size() ? count - events.size() : 0;
+      for(auto i = first; i < count; ++i) {
+        callable(events[i % events.size()]);
+      }
+    }
+
+    std::size_t GetThreadId() const {
+      return thread_id;
+    }
+
+  private:
+
+    const std::size_t thread_id;
+    std::vector<TraceEvent> events;
+    std::size_t count;
+  };
+
+  Tracer() = default;
+
+  // Буферы принадлежат Tracer, чтобы интервалы завершившихся потоков попали в выгрузку.
+  TraceBuffer* Register() {
+    std::lock_guard<std::mutex> lock{mutex};
+    buffers.push_back(std::make_unique<TraceBuffer>(buffers.size() + 1, buffer_capacity));
+    return buffers.back().get();
+  }
+
+  static std::string Fraction(std::uint64_t nanoseconds) {
+    auto fraction = std::to_string(nanoseconds % 1000);
+    return std::string(3 - fraction.size(), '0') + fraction;
+  }
+
+  std::atomic<bool> is_enabled{false};
+  std::mutex mutex;
+  std::size_t buffer_capacity{0};
+  std::vector<std::unique_ptr<TraceBuffer>> buffers;
+};
+
+// Интервал от создания до разрушения объекта, bulk - метка времени блока.
+class TraceSpan
+{
+public:
+
+  explicit TraceSpan(const char* name, std::uint64_t bulk = 0)
+    : name{name}, bulk{bulk}, start{Tracer::Instance().IsEnabled() ? Tracer::Now() : 0} {}
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+  ~TraceSpan() {
+    if(0 != start) {
+      Tracer::Instance().Record(name, start, Tracer::Now(), bulk);
+    }
+  }
+
+  void SetBulk(std::uint64_t timestamp) {
+    bulk = timestamp;
+  }
+
+private:
+
+  const char* name;
+  std::uint64_t bulk;
+  const std::uint64_t start;
+};
+
+#ifdef BULK_TRACING
+#define TRACE_SPAN(var, name, bulk) TraceSpan var{name, bulk}
+#define TRACE_SET_BULK(var, bulk) var.SetBulk(bulk)
+#else
+#define TRACE_SPAN(var, name, bulk)
+#define TRACE_SET_BULK(var, bulk)
+#endif
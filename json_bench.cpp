@@ -0,0 +1,107 @@
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include "ConsoleOutput.h"
+#include "JsonOutput.h"
+
+// Сравнивает скорость текстового и JSON форматирования блоков, а также векторного
+// и побайтного экранирования. Скорость считается по объёму текста команд.
+
+// Копирует вывод в циклический буфер, чтобы оба форматтера платили за запись байтов.
+class SinkStreambuf : public std::streambuf
+{
+protected:
+
+  int_type overflow(int_type symbol) override {
+    char data = traits_type::to_char_type(symbol);
+    xsputn(&data, 1);
+    return symbol;
+  }
+
+  std::streamsize xsputn(const char* data, std::streamsize size) override {
+    for(auto rest = size; 0 != rest;) {
+      auto chunk = std::min<std::streamsize>(rest, sizeof(sink) - position);
+      std::memcpy(sink + position, data, chunk);
+      position = (position + chunk) % sizeof(sink);
+      data += chunk;
+      rest -= chunk;
+    }
+    return size;
+  }
+
+private:
+
+  char sink[1 << 20];
+  std::size_t position{0};
+};
+
+template<typename Callable>
+double MeasureMBps(std::size_t bytes, Callable&& callable) {
+  const int iterations = 200;
+  callable();
+  auto start = std::chrono::steady_clock::now();
+  for(int i = 0; i < iterations; ++i) {
+    callable();
+  }
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return bytes * iterations / elapsed / (1 << 20);
+}
+
+void Run(const std::string& title, const std::string& command) {
+  const std::size_t bulk_size = 16;
+  const std::size_t bulk_count = 64;
+  Bulk bulk(bulk_size, Command{command});
+  auto bytes = command.size() * bulk_size * bulk_count;
+
+  auto sink_streambuf = std::make_unique<SinkStreambuf>();
+  std::ostream sink_stream{sink_streambuf.get()};
+  ConsoleOutput text_output{sink_stream};
+  JsonOutput json_output{sink_stream};
+  std::vector<char> escaped(JsonEscapedMaxSize(command.size()));
+
+  auto text = MeasureMBps(bytes, [&] {
+    for(std::size_t i = 0; i < bulk_count; ++i) {
+      text_output.Output(i, bulk);
+    }
+  });
+  auto json = MeasureMBps(bytes, [&] {
+    for(std::size_t i = 0; i < bulk_count; ++i) {
+      json_output.OutputBulk(i, bulk, false);
+    }
+  });
+  auto vectorized = MeasureMBps(bytes, [&] {
+    for(std::size_t i = 0; i < bulk_count * bulk_size; ++i) {
+      WriteJsonEscaped(escaped.data(), command.data(), command.size());
+    }
+  });
+  auto scalar = MeasureMBps(bytes, [&] {
+    for(std::size_t i = 0; i < bulk_count * bulk_size; ++i) {
+      WriteJsonEscapedScalar(escaped.data(), command.data(), command.size());
+    }
+  });
+
+  std::cout << std::fixed << std::setprecision(0)
+            << title << '\n'
+            << "  text formatter, MB/s:  " << text << '\n'
+            << "  json formatter, MB/s:  " << json << '\n'
+            << "  escape simd, MB/s:     " << vectorized << '\n'
+            << "  escape scalar, MB/s:   " << scalar << std::endl;
+}
+
+int main()
+{
+  std::string long_command;
+  while(long_command.size() < 4096) {
+    long_command += "SELECT id, name FROM table WHERE value > 42 ORDER BY name; ";
+  }
+  std::string escape_heavy_command;
+  while(escape_heavy_command.size() < 4096) {
+    escape_heavy_command += "{\"path\":\"C:\\\\dir\\\\file\",\n\t\"msg\":\"say \\\"hi\\\"\"} ";
+  }
+
+  Run("long commands (4 KiB, no escapes)", long_command);
+  Run("escape-heavy commands (4 KiB)", escape_heavy_command);
+  Run("short commands (cmd1)", "cmd1");
+  return 0;
+}
@@ -0,0 +1,162 @@
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ParsePositive.h"
+
+// Нагрузочный клиент для bulk --daemon. Каждый поток открывает свою долю соединений,
+// держит их открытыми одновременно, по очереди отправляет в них команды, затем закрывает.
+
+int Connect(const std::string& socket_path) {
+  auto fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(-1 == fd) {
+    throw std::runtime_error("Connect. Can't create socket.");
+  }
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+  while(-1 == connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address))) {
+    // Очередь ожидающих соединений переполнена, повторяем попытку.
+    if(EAGAIN == errno || EINTR == errno) {
+      std::this_thread::yield();
+      continue;
+    }
+    close(fd);
+    throw std::runtime_error("Connect. Can't connect to socket.");
+  }
+  return fd;
+}
+
+// Возвращает false, если сервер закрыл соединение.
+bool WriteAll(int fd, const std::string& data) {
+  auto ptr = data.data();
+  auto size = data.size();
+  while(0 != size) {
+    auto result = write(fd, ptr, size);
+    if(-1 == result) {
+      if(EINTR == errno) {
+        continue;
+      }
+      if(EPIPE == errno || ECONNRESET == errno) {
+        return false;
+      }
+      throw std::runtime_error("WriteAll. Failed to write to socket.");
+    }
+    ptr += result;
+    size -= result;
+  }
+  return true;
+}
+
+int main(int argc, char const* argv[])
+{
+  try
+  {
+    std::string socket_path;
+    std::size_t connection_count;
+    std::size_t command_count;
+    std::size_t thread_count{4};
+    std::size_t batch_size{16};
+    try
+    {
+      if(4 > argc || 6 < argc)
+        throw std::invalid_argument("");
+      socket_path = argv[1];
+      connection_count = ParsePositive(argv[2]);
+      command_count = ParsePositive(argv[3]);
+      if(5 <= argc)
+        thread_count = ParsePositive(argv[4]);
+      if(6 <= argc)
+        batch_size = ParsePositive(argv[5]);
+    }
+    catch(...)
+    {
+      throw std::invalid_argument("The programm must be started as: bulk_load <socket path> <connections>"
+                                  " <commands per connection> [threads] [commands per write].");
+    }
+
+    // Соединение, закрытое сервером, считается неудачным, а не завершает процесс.
+    signal(SIGPIPE, SIG_IGN);
+
+    std::atomic<std::size_t> failed_count{0};
+    std::atomic<std::size_t> failed_connection_count{0};
+    std::vector<double> connect_times(thread_count);
+    auto worker = [&] (std::size_t index) {
+      try {
+        auto count = connection_count / thread_count + (index < connection_count % thread_count ? 1 : 0);
+        std::vector<int> fds;
+        fds.reserve(count);
+
+        auto start = std::chrono::steady_clock::now();
+        for(std::size_t i = 0; i < count; ++i) {
+          fds.push_back(Connect(socket_path));
+        }
+        connect_times[index] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::string batch;
+        for(std::size_t sent = 0; sent < command_count; sent += batch_size) {
+          for(std::size_t i = 0; i < fds.size(); ++i) {
+            if(-1 == fds[i]) {
+              continue;
+            }
+            batch.clear();
+            for(std::size_t j = sent; j < std::min(sent + batch_size, command_count); ++j) {
+              batch += "cmd" + std::to_string(index) + "_" + std::to_string(i) + "_" + std::to_string(j) + "\n";
+            }
+            if(!WriteAll(fds[i], batch)) {
+              ++failed_connection_count;
+              close(fds[i]);
+              fds[i] = -1;
+            }
+          }
+        }
+
+        for(auto fd : fds) {
+          if(-1 != fd) {
+            close(fd);
+          }
+        }
+      }
+      catch(const std::exception& e) {
+        ++failed_count;
+        std::cerr << e.what() << std::endl;
+      }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for(std::size_t i = 0; i < thread_count; ++i) {
+      threads.emplace_back(worker, i);
+    }
+    for(auto& thread : threads) {
+      thread.join();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto connect_time = *std::max_element(std::cbegin(connect_times), std::cend(connect_times));
+
+    std::cerr << std::fixed << std::setprecision(3)
+              << "connections:      " << connection_count << '\n'
+              << "commands:         " << connection_count * command_count << '\n'
+              << "failed threads:   " << failed_count << '\n'
+              << "failed conns:     " << failed_connection_count << '\n'
+              << "elapsed, s:       " << elapsed << '\n'
+              << "connections/s:    " << connection_count / connect_time << '\n'
+              << "commands/s:       " << connection_count * command_count / elapsed << std::endl;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+  }
+  return 0;
+}
@@ -1,48 +1,172 @@
+#include <signal.h>
+#include <sys/resource.h>
 #include <algorithm>
 #include <limits>
+#include <vector>
+#include "ParsePositive.h"
 #include "Storage.h"
 #include "ConsoleOutput.h"
+#include "BufferedConsoleOutput.h"
 #include "FileOutput.h"
+#include "SharedMemoryOutput.h"
+#include "JsonOutput.h"
 #include "CommandProcessor.h"
+#include "BulkServer.h"
+#include "Tracer.h"
+
+// Сервер держит по дескриптору на соединение, поэтому мягкий предел числа открытых
+// файлов поднимается до жёсткого. Соединения сверх предела сервер закрывает сразу.
+void RaiseOpenFilesLimit() {
+  rlimit limit;
+  if(0 == getrlimit(RLIMIT_NOFILE, &limit) && limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+}
 
 int main(int argc, char const* argv[])
 {
   try
   {
     unsigned long long block_size;
+    std::string shm_name;
+    unsigned long long shm_slot_count{1024};
+    unsigned long long shm_slot_size{4096};
+    std::string capture_filename;
+    std::unique_ptr<FlushPolicy> flush_policy;
+    std::string socket_path;
+    unsigned long long thread_count{2};
+    bool is_thread_count_set{false};
+    std::string trace_filename;
+    std::string json_filename;
     try
     {
-      if(2 != argc)
+      if(2 > argc || 0 != argc % 2)
         throw std::invalid_argument("");
 
-      std::string digit_str{argv[1]};
-      if(!std::all_of(std::cbegin(digit_str),
-                      std::cend(digit_str),
-                      [](unsigned char symbol) { return std::isdigit(symbol); } ))
+      block_size = ParsePositive(argv[1]);
+
+      for(int i = 2; i < argc; i += 2) {
+        std::string option{argv[i]};
+        if("--shm" == option)
+          shm_name = argv[i + 1];
+        else if("--shm-slots" == option)
+          shm_slot_count = ParsePositive(argv[i + 1]);
+        else if("--shm-slot-size" == option)
+          shm_slot_size = ParsePositive(argv[i + 1]);
+        else if("--capture" == option)
+          capture_filename = argv[i + 1];
+        else if("--flush" == option)
+          flush_policy = std::make_unique<FlushPolicy>(FlushPolicy::Parse(argv[i + 1]));
+        else if("--daemon" == option)
+          socket_path = argv[i + 1];
+        else if("--threads" == option) {
+          thread_count = ParsePositive(argv[i + 1]);
+          is_thread_count_set = true;
+        }
+        else if("--json" == option)
+          json_filename = argv[i + 1];
+        else if("--trace" == option && Tracer::is_compiled_in)
+          trace_filename = argv[i + 1];
+        else
+          throw std::invalid_argument("");
+      }
+
+      if(shm_slot_count > std::numeric_limits<std::uint32_t>::max()
+        || shm_slot_size > std::numeric_limits<std::uint32_t>::max())
         throw std::invalid_argument("");
 
-      block_size = std::stoull(digit_str);
-      if(0 == block_size)
+      // Сервер разбирает команды соединений без записи трассы.
+      if(!socket_path.empty() && !capture_filename.empty())
+        throw std::invalid_argument("");
+      if(socket_path.empty() && is_thread_count_set)
         throw std::invalid_argument("");
     }
     catch(...)
     {
-      std::string error_msg = "The programm must be started with only one parameter. It must be a digit from 1 to "
+      std::string error_msg = "The programm must be started with one parameter. It must be a digit from 1 to "
                               + std::to_string(std::numeric_limits<decltype(block_size)>::max())
-                              + " in decimal base.";
+                              + " in decimal base. Optionally it may be followed by --shm <name> to publish bulks"
+                                " to shared memory, --shm-slots <count> and --shm-slot-size <bytes> set its ring size (1024 slots of 4096 bytes"
+                                " by default), --capture <file> to record input into a trace file and --flush <policy>"
+                                " to buffer console output. Policy is one of bulk, bytes:N (N up to 67108864), bulks:N, ms:T. With --daemon <socket path>"
+                                " commands are read from clients of UNIX socket by --threads <count> threads (2 by default),"
+                                " --capture can't be used together with --daemon."
+                                " --json <file> appends bulks to the file in JSON lines format. In builds with BULK_TRACING option"
+                                " --trace <file> writes Chrome trace of processing stages.";
       throw std::invalid_argument(error_msg);
     }
 
-    auto commandProcessor = std::make_unique<CommandProcessor>();
-    std::shared_ptr<Storage> storage = std::make_shared<Storage>(block_size);
-    std::shared_ptr<IOutput> consoleOutput = std::make_shared<ConsoleOutput>(std::cout);
-    std::shared_ptr<IOutput> fileOutput = std::make_shared<FileOutput>();
+    // В режиме демона сигналы завершения ожидаются в основном потоке. Они блокируются
+    // до создания получателей и потоков сервера, чтобы все потоки унаследовали маску.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    if(!socket_path.empty()) {
+      pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    }
 
-    storage->Subscribe(consoleOutput);
-    storage->Subscribe(fileOutput);
-    commandProcessor->Subscribe(storage);
+    std::ofstream json_ofs;
+    // Получатели вызываются в порядке подписки: разделяемая память подписывается первой,
+    // чтобы блок попадал к потребителю, не дожидаясь вывода на консоль и в файл.
+    std::vector<std::shared_ptr<IOutput>> outputs;
+    if(!shm_name.empty()) {
+      outputs.push_back(std::make_shared<SharedMemoryOutput>(shm_name, shm_slot_count, shm_slot_size));
+    }
+    if(flush_policy) {
+      outputs.push_back(std::make_shared<BufferedConsoleOutput>(*flush_policy));
+    }
+    else {
+      outputs.push_back(std::make_shared<ConsoleOutput>(std::cout));
+    }
+    outputs.push_back(std::make_shared<FileOutput>());
+    if(!json_filename.empty()) {
+      json_ofs.open(json_filename.c_str(), std::ofstream::out | std::ofstream::app);
+      if(json_ofs.fail()) {
+        throw std::runtime_error("Can't open JSON output file.");
+      }
+      outputs.push_back(std::make_shared<JsonOutput>(json_ofs));
+    }
 
-    commandProcessor->Process(std::cin);
+    if(!trace_filename.empty()) {
+      Tracer::Instance().Enable();
+    }
+
+    if(!socket_path.empty()) {
+      RaiseOpenFilesLimit();
+
+      BulkServer server{socket_path, block_size, thread_count};
+      for(const auto& output : outputs) {
+        server.Subscribe(output);
+      }
+      server.Start();
+
+      int signal_number;
+      sigwait(&signals, &signal_number);
+      server.Stop();
+    }
+    else {
+      auto commandProcessor = std::make_unique<CommandProcessor>();
+      std::shared_ptr<Storage> storage = std::make_shared<Storage>(block_size);
+      for(const auto& output : outputs) {
+        storage->Subscribe(output);
+      }
+      commandProcessor->Subscribe(storage);
+      if(!capture_filename.empty()) {
+        commandProcessor->Capture(std::make_shared<TraceWriter>(capture_filename));
+      }
+
+      commandProcessor->Process(std::cin);
+    }
+
+    if(!trace_filename.empty()) {
+      std::ofstream ofs{trace_filename.c_str(), std::ofstream::out | std::ofstream::trunc};
+      Tracer::Instance().Dump(ofs);
+      if(ofs.fail()) {
+        throw std::runtime_error("Failed to write trace file.");
+      }
+    }
   }
   catch (const std::exception& e)
   {
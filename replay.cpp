@@ -0,0 +1,134 @@
+#include <sys/resource.h>
+#include <algorithm>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include "ParsePositive.h"
+#include "Storage.h"
+#include "ConsoleOutput.h"
+#include "FileOutput.h"
+#include "CommandProcessor.h"
+
+// Замеряет задержку от поступления первой команды блока до его вывода.
+// Подписывается последним, чтобы учесть время работы остальных получателей.
+class LatencyOutput : public IOutput
+{
+
+public:
+
+  const char* Name() const override {
+    return "LatencyOutput";
+  }
+
+  void Output(const std::size_t timestamp, const Bulk&) override {
+    auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+    latencies.push_back(now - timestamp);
+  }
+
+  std::vector<std::size_t>& GetLatencies() {
+    return latencies;
+  }
+
+private:
+
+  std::vector<std::size_t> latencies;
+};
+
+std::size_t Percentile(const std::vector<std::size_t>& sorted, double percentile) {
+  if(sorted.empty()) {
+    return 0;
+  }
+  auto index = static_cast<std::size_t>(percentile / 100 * (sorted.size() - 1) + 0.5);
+  return sorted[index];
+}
+
+int main(int argc, char const* argv[])
+{
+  try
+  {
+    std::string trace_filename;
+    unsigned long long block_size;
+    double speed{1};
+    try
+    {
+      if(3 != argc && 4 != argc)
+        throw std::invalid_argument("");
+
+      trace_filename = argv[1];
+
+      block_size = ParsePositive(argv[2]);
+
+      if(4 == argc) {
+        std::string speed_str{argv[3]};
+        if("max" == speed_str) {
+          speed = 0;
+        }
+        else {
+          std::size_t pos;
+          speed = std::stod(speed_str, &pos);
+          if(pos != speed_str.size() || speed <= 0)
+            throw std::invalid_argument("");
+        }
+      }
+    }
+    catch(...)
+    {
+      throw std::invalid_argument("The programm must be started as: bulk_replay <trace file> <block size> [speed]."
+                                  " Speed is a positive multiplier of the original speed or \"max\"."
+                                  " Default speed is 1.");
+    }
+
+    TraceReader reader{trace_filename};
+    auto commandProcessor = std::make_unique<CommandProcessor>();
+    std::shared_ptr<Storage> storage = std::make_shared<Storage>(block_size);
+    std::shared_ptr<IOutput> consoleOutput = std::make_shared<ConsoleOutput>(std::cout);
+    std::shared_ptr<IOutput> fileOutput = std::make_shared<FileOutput>();
+    auto latencyOutput = std::make_shared<LatencyOutput>();
+
+    storage->Subscribe(consoleOutput);
+    storage->Subscribe(fileOutput);
+    storage->Subscribe(latencyOutput);
+    commandProcessor->Subscribe(storage);
+
+    std::uint64_t time;
+    std::string command;
+    std::size_t command_count{0};
+    auto start = std::chrono::steady_clock::now();
+    while(reader.Next(time, command)) {
+      if(0 != speed) {
+        std::this_thread::sleep_until(start + std::chrono::microseconds{static_cast<std::uint64_t>(time / speed)});
+      }
+      commandProcessor->ProcessCommand(command);
+      ++command_count;
+    }
+    commandProcessor->Finish();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto& latencies = latencyOutput->GetLatencies();
+    std::sort(std::begin(latencies), std::end(latencies));
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    std::cerr << std::fixed << std::setprecision(3)
+              << "commands:         " << command_count << '\n'
+              << "bulks:            " << latencies.size() << '\n'
+              << "elapsed, s:       " << elapsed << '\n'
+              << "commands/s:       " << command_count / elapsed << '\n'
+              << "bulks/s:          " << latencies.size() / elapsed << '\n'
+              << "latency p50, us:  " << Percentile(latencies, 50) << '\n'
+              << "latency p90, us:  " << Percentile(latencies, 90) << '\n'
+              << "latency p99, us:  " << Percentile(latencies, 99) << '\n'
+              << "latency p999, us: " << Percentile(latencies, 99.9) << '\n'
+              << "latency max, us:  " << (latencies.empty() ? 0 : latencies.back()) << '\n'
+              << "peak memory, KiB: " << usage.ru_maxrss << std::endl;
+    if(reader.IsTruncated()) {
+      std::cerr << "trace is truncated, the last record was skipped" << std::endl;
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,55 @@
+#include <iostream>
+#include <thread>
+#include "SharedMemoryReader.h"
+
+// Пример читателя: выводит блоки, публикуемые bulk --shm <name>.
+int main(int argc, char const* argv[])
+{
+  try
+  {
+    if(2 != argc) {
+      throw std::invalid_argument("The programm must be started with only one parameter. It must be a name of shared memory object.");
+    }
+
+    SharedMemoryReader reader{argv[1]};
+    std::size_t timestamp;
+    std::string bulk;
+    std::uint64_t lost_count{0};
+    std::uint64_t truncated_count{0};
+    std::size_t idle_count{0};
+    bool is_producer_closed{false};
+
+    for(;;) {
+      if(reader.TryRead(timestamp, bulk)) {
+        idle_count = 0;
+        if(lost_count != reader.GetLostCount()) {
+          std::cerr << "lost " << reader.GetLostCount() - lost_count << " slots" << std::endl;
+          lost_count = reader.GetLostCount();
+        }
+        if(truncated_count != reader.GetTruncatedCount()) {
+          std::cerr << "truncated bulk of " << bulk.size() << " bytes" << std::endl;
+          truncated_count = reader.GetTruncatedCount();
+        }
+        std::cout << timestamp << ' ' << bulk << std::flush;
+        continue;
+      }
+      if(is_producer_closed) {
+        std::cerr << "producer closed" << std::endl;
+        break;
+      }
+      // Активное ожидание без системных вызовов, затем уступаем процессор.
+      if(++idle_count > 100000) {
+        std::this_thread::yield();
+        // Блоки, опубликованные до закрытия, дочитываются на следующей итерации.
+        if(0 == idle_count % 100000 && !reader.IsProducerAlive()) {
+          is_producer_closed = true;
+        }
+      }
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+  }
+  return 0;
+}
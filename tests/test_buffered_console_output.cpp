@@ -0,0 +1,178 @@
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include "BufferedConsoleOutput.h"
+
+#define BOOST_TEST_MODULE test_buffered_console_output
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+
+struct console_pipe
+{
+  console_pipe() {
+    BOOST_REQUIRE_EQUAL(0, pipe2(fds, O_NONBLOCK));
+  }
+
+  ~console_pipe() {
+    close(fds[0]);
+    close(fds[1]);
+  }
+
+  std::string Read() {
+    char buffer[4096];
+    auto result = read(fds[0], buffer, sizeof(buffer));
+    return -1 == result ? std::string{} : std::string(buffer, result);
+  }
+
+  std::string ReadAll() {
+    std::string result;
+    for(auto part = Read(); !part.empty(); part = Read()) {
+      result += part;
+    }
+    return result;
+  }
+
+  int fds[2];
+};
+
+BOOST_FIXTURE_TEST_SUITE(test_suite_main, console_pipe)
+
+BOOST_AUTO_TEST_CASE(parse_flush_policy)
+{
+  BOOST_CHECK(FlushPolicy::Kind::EveryBulk == FlushPolicy::Parse("bulk").kind);
+
+  auto policy = FlushPolicy::Parse("bytes:4096");
+  BOOST_CHECK(FlushPolicy::Kind::Bytes == policy.kind);
+  BOOST_CHECK_EQUAL(4096, policy.value);
+
+  policy = FlushPolicy::Parse("bulks:10");
+  BOOST_CHECK(FlushPolicy::Kind::Bulks == policy.kind);
+  BOOST_CHECK_EQUAL(10, policy.value);
+
+  policy = FlushPolicy::Parse("ms:5");
+  BOOST_CHECK(FlushPolicy::Kind::Interval == policy.kind);
+  BOOST_CHECK_EQUAL(5, policy.value);
+
+  BOOST_CHECK_THROW(FlushPolicy::Parse("bulks"), std::invalid_argument);
+  BOOST_CHECK_THROW(FlushPolicy::Parse("bulks:"), std::invalid_argument);
+  BOOST_CHECK_THROW(FlushPolicy::Parse("bulks:0"), std::invalid_argument);
+  BOOST_CHECK_THROW(FlushPolicy::Parse("bulks:-1"), std::invalid_argument);
+  BOOST_CHECK_THROW(FlushPolicy::Parse("lines:1"), std::invalid_argument);
+  BOOST_CHECK_THROW(FlushPolicy::Parse("bytes:" + std::to_string(FlushPolicy::max_bytes + 1)),
+                    std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(flush_every_bulk)
+{
+  BufferedConsoleOutput output{FlushPolicy::Parse("bulk"), fds[1]};
+
+  output.Output(1, {"cmd1", "cmd2"});
+  BOOST_CHECK_EQUAL("bulk: cmd1, cmd2\n", Read());
+}
+
+BOOST_AUTO_TEST_CASE(flush_by_bulks)
+{
+  BufferedConsoleOutput output{FlushPolicy::Parse("bulks:2"), fds[1]};
+
+  output.Output(1, {"cmd1"});
+  BOOST_CHECK_EQUAL("", Read());
+  output.Output(2, {"cmd2"});
+  BOOST_CHECK_EQUAL("bulk: cmd1\nbulk: cmd2\n", Read());
+}
+
+BOOST_AUTO_TEST_CASE(flush_by_bytes)
+{
+  BufferedConsoleOutput output{FlushPolicy::Parse("bytes:20"), fds[1]};
+
+  output.Output(1, {"cmd1"});
+  BOOST_CHECK_EQUAL("", Read());
+  output.Output(2, {"cmd2"});
+  BOOST_CHECK_EQUAL("bulk: cmd1\nbulk: cmd2\n", Read());
+}
+
+BOOST_AUTO_TEST_CASE(flush_by_bytes_above_capacity)
+{
+  BufferedConsoleOutput output{FlushPolicy::Parse("bytes:44"), fds[1], 16};
+
+  output.Output(1, {"cmd1"});
+  output.Output(2, {"cmd2"});
+  output.Output(3, {"cmd3"});
+  BOOST_CHECK_EQUAL("", Read());
+  output.Output(4, {"cmd4"});
+  BOOST_CHECK_EQUAL("bulk: cmd1\nbulk: cmd2\nbulk: cmd3\nbulk: cmd4\n", Read());
+}
+
+BOOST_AUTO_TEST_CASE(flush_by_interval)
+{
+  BufferedConsoleOutput output{FlushPolicy::Parse("ms:10"), fds[1]};
+
+  output.Output(1, {"cmd1"});
+  std::this_thread::sleep_for(std::chrono::milliseconds{200});
+  BOOST_CHECK_EQUAL("bulk: cmd1\n", Read());
+}
+
+BOOST_AUTO_TEST_CASE(flush_on_destruction)
+{
+  {
+    BufferedConsoleOutput output{FlushPolicy::Parse("bulks:100"), fds[1]};
+    output.Output(1, {"cmd1"});
+    BOOST_CHECK_EQUAL("", Read());
+  }
+  BOOST_CHECK_EQUAL("bulk: cmd1\n", Read());
+}
+
+BOOST_AUTO_TEST_CASE(bulk_larger_than_buffer)
+{
+  BufferedConsoleOutput output{FlushPolicy::Parse("bulks:100"), fds[1], 16};
+
+  output.Output(1, {"cmd1"});
+  output.Output(2, {"cmd1234567890"});
+  BOOST_CHECK_EQUAL("bulk: cmd1\nbulk: cmd1234567890\n", Read());
+}
+
+BOOST_AUTO_TEST_CASE(flush_on_signal)
+{
+  // Накопленный вывод больше одной части сброса SignalSafeBuffer.
+  const int bulk_count = 1000;
+  auto pid = fork();
+  BOOST_REQUIRE_NE(-1, pid);
+  if(0 == pid) {
+    BufferedConsoleOutput output{FlushPolicy::Parse("bulks:100000"), fds[1]};
+    for(int i = 0; i < bulk_count; ++i) {
+      output.Output(i, {"cmd" + std::to_string(i)});
+    }
+    raise(SIGTERM);
+    _exit(0);
+  }
+  int status;
+  BOOST_REQUIRE_EQUAL(pid, waitpid(pid, &status, 0));
+  BOOST_CHECK(WIFSIGNALED(status));
+
+  std::string result;
+  for(int i = 0; i < bulk_count; ++i) {
+    result += "bulk: cmd" + std::to_string(i) + "\n";
+  }
+  BOOST_CHECK_EQUAL(result, ReadAll());
+}
+
+BOOST_AUTO_TEST_CASE(flush_on_exit)
+{
+  auto pid = fork();
+  BOOST_REQUIRE_NE(-1, pid);
+  if(0 == pid) {
+    // Объект не разрушается до exit, вывод сбрасывает обработчик atexit.
+    auto output = new BufferedConsoleOutput{FlushPolicy::Parse("bulks:100"), fds[1]};
+    output->Output(1, {"cmd1"});
+    std::exit(0);
+  }
+  int status;
+  BOOST_REQUIRE_EQUAL(pid, waitpid(pid, &status, 0));
+  BOOST_CHECK(WIFEXITED(status));
+
+  BOOST_CHECK_EQUAL("bulk: cmd1\n", ReadAll());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
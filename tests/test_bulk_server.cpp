@@ -0,0 +1,226 @@
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <thread>
+#include "BulkServer.h"
+
+#define BOOST_TEST_MODULE test_bulk_server
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+
+class TestOutput : public IOutput
+{
+public:
+
+  const char* Name() const override {
+    return "TestOutput";
+  }
+
+  void Output(const std::size_t, const Bulk& data) override {
+    std::ostringstream oss;
+    OutputFormattedBulk(oss, data);
+    std::lock_guard<std::mutex> lock{mutex};
+    bulks.push_back(oss.str());
+  }
+
+  std::vector<std::string> GetBulks() {
+    std::lock_guard<std::mutex> lock{mutex};
+    return bulks;
+  }
+
+private:
+
+  std::mutex mutex;
+  std::vector<std::string> bulks;
+};
+
+struct running_server
+{
+  running_server()
+    : socket_path{"test_bulk_server_" + std::to_string(getpid()) + ".sock"},
+      server{std::make_unique<BulkServer>(socket_path, 3, 2)},
+      output{std::make_shared<TestOutput>()} {
+    server->Subscribe(output);
+    server->Start();
+  }
+
+  void Send(const std::string& data) {
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    BOOST_REQUIRE_NE(-1, fd);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+    BOOST_REQUIRE_NE(-1, connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)));
+    BOOST_REQUIRE_EQUAL(data.size(), write(fd, data.data(), data.size()));
+    close(fd);
+  }
+
+  void WaitForBulks(std::size_t count) {
+    for(int i = 0; i < 200 && output->GetBulks().size() < count; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+  }
+
+  std::string socket_path;
+  std::unique_ptr<BulkServer> server;
+  std::shared_ptr<TestOutput> output;
+};
+
+BOOST_FIXTURE_TEST_SUITE(test_suite_main, running_server)
+
+BOOST_AUTO_TEST_CASE(merge_static_bulks_from_connections)
+{
+  Send("cmd1\ncmd2\n");
+  // Последняя строка без перевода строки обрабатывается при закрытии соединения.
+  Send("cmd3");
+
+  WaitForBulks(1);
+  auto bulks = output->GetBulks();
+  BOOST_REQUIRE_EQUAL(1, bulks.size());
+  BOOST_CHECK((bulks[0] == "bulk: cmd1, cmd2, cmd3\n")
+              || (bulks[0] == "bulk: cmd3, cmd1, cmd2\n"));
+}
+
+BOOST_AUTO_TEST_CASE(dynamic_bulks_per_connection)
+{
+  Send("cmd1\n{\ncmd2\n{\ncmd3\n}\ncmd4\n}\ncmd5\n");
+  WaitForBulks(1);
+  BOOST_REQUIRE_EQUAL(1, output->GetBulks().size());
+  BOOST_CHECK_EQUAL("bulk: cmd2, cmd3, cmd4\n", output->GetBulks()[0]);
+
+  // Незавершённый динамический блок отбрасывается при закрытии соединения.
+  Send("{\ncmd6\n");
+  server->Stop();
+
+  auto bulks = output->GetBulks();
+  BOOST_REQUIRE_EQUAL(2, bulks.size());
+  BOOST_CHECK_EQUAL("bulk: cmd1, cmd5\n", bulks[1]);
+}
+
+BOOST_AUTO_TEST_CASE(partial_lines)
+{
+  auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  BOOST_REQUIRE_NE(-1, fd);
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+  BOOST_REQUIRE_NE(-1, connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)));
+
+  for(std::string part : {"cm", "d1\ncmd", "2\n", "cmd3\n"}) {
+    BOOST_REQUIRE_EQUAL(part.size(), write(fd, part.data(), part.size()));
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+  }
+
+  WaitForBulks(1);
+  BOOST_REQUIRE_EQUAL(1, output->GetBulks().size());
+  BOOST_CHECK_EQUAL("bulk: cmd1, cmd2, cmd3\n", output->GetBulks()[0]);
+  close(fd);
+}
+
+BOOST_AUTO_TEST_CASE(refuse_path_of_running_server)
+{
+  BulkServer second_server{socket_path, 3, 1};
+  BOOST_CHECK_THROW(second_server.Start(), std::runtime_error);
+  second_server.Stop();
+
+  // Сокет работающего сервера не удалён.
+  Send("cmd1\ncmd2\ncmd3\n");
+  WaitForBulks(1);
+  BOOST_CHECK_EQUAL(1, output->GetBulks().size());
+}
+
+BOOST_AUTO_TEST_CASE(refuse_path_of_regular_file)
+{
+  auto filename = socket_path + ".txt";
+  std::ofstream{filename.c_str()} << "data";
+
+  {
+    BulkServer file_server{filename, 3, 1};
+    BOOST_CHECK_THROW(file_server.Start(), std::runtime_error);
+  }
+
+  std::ifstream ifs{filename.c_str()};
+  std::string content;
+  ifs >> content;
+  BOOST_CHECK_EQUAL("data", content);
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(replace_stale_socket)
+{
+  auto stale_path = socket_path + ".stale";
+  auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  BOOST_REQUIRE_NE(-1, fd);
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, stale_path.c_str(), sizeof(address.sun_path) - 1);
+  BOOST_REQUIRE_NE(-1, bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)));
+  close(fd);
+
+  BulkServer stale_server{stale_path, 3, 1};
+  BOOST_CHECK_NO_THROW(stale_server.Start());
+  stale_server.Stop();
+  BOOST_CHECK_EQUAL(-1, access(stale_path.c_str(), F_OK));
+}
+
+BOOST_AUTO_TEST_CASE(reject_connections_over_open_files_limit)
+{
+  // Сокеты клиентов создаются до снижения предела, connect новых дескрипторов не требует.
+  std::vector<int> clients;
+  for(int i = 0; i < 8; ++i) {
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    BOOST_REQUIRE_NE(-1, fd);
+    clients.push_back(fd);
+  }
+  rlimit limit;
+  BOOST_REQUIRE_EQUAL(0, getrlimit(RLIMIT_NOFILE, &limit));
+  auto saved_limit = limit;
+  limit.rlim_cur = *std::max_element(std::cbegin(clients), std::cend(clients)) + 1;
+  BOOST_REQUIRE_EQUAL(0, setrlimit(RLIMIT_NOFILE, &limit));
+
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+  for(auto fd : clients) {
+    BOOST_REQUIRE_NE(-1, connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)));
+  }
+
+  // Сервер закрывает соединения, которые не может принять.
+  for(auto fd : clients) {
+    pollfd poll_fd{fd, POLLIN, 0};
+    auto is_ready = 1 == poll(&poll_fd, 1, 1000);
+    BOOST_CHECK(is_ready);
+    char symbol;
+    if(is_ready) {
+      BOOST_CHECK_EQUAL(0, read(fd, &symbol, sizeof(symbol)));
+    }
+  }
+
+  // И не занимает процессор, пока предел не поднят.
+  auto cpu_time = [] {
+    timespec time;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+    return time.tv_sec * 1000 + time.tv_nsec / 1000000;
+  };
+  auto cpu_start = cpu_time();
+  std::this_thread::sleep_for(std::chrono::milliseconds{200});
+  BOOST_CHECK_LT(cpu_time() - cpu_start, 50);
+
+  for(auto fd : clients) {
+    close(fd);
+  }
+  BOOST_REQUIRE_EQUAL(0, setrlimit(RLIMIT_NOFILE, &saved_limit));
+  Send("cmd1\ncmd2\ncmd3\n");
+  WaitForBulks(1);
+  BOOST_CHECK_EQUAL(1, output->GetBulks().size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,176 @@
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include "Storage.h"
+#include "ConsoleOutput.h"
+#include "CommandProcessor.h"
+
+#define BOOST_TEST_MODULE test_command_trace
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+
+struct trace_file
+{
+  trace_file()
+    : filename{"test_command_trace.trc"} {}
+
+  ~trace_file() {
+    std::remove(filename.c_str());
+  }
+
+  std::string filename;
+  std::uint64_t time;
+  std::string line;
+};
+
+BOOST_FIXTURE_TEST_SUITE(test_suite_main, trace_file)
+
+BOOST_AUTO_TEST_CASE(write_and_read_records)
+{
+  std::string long_line(1000, 'x');
+  {
+    TraceWriter writer{filename};
+    writer.Write("cmd1");
+    writer.Write("");
+    writer.Write(long_line);
+  }
+
+  TraceReader reader{filename};
+  std::uint64_t previous_time{0};
+
+  BOOST_REQUIRE_EQUAL(true, reader.Next(time, line));
+  BOOST_CHECK_EQUAL("cmd1", line);
+  previous_time = time;
+
+  BOOST_REQUIRE_EQUAL(true, reader.Next(time, line));
+  BOOST_CHECK_EQUAL("", line);
+  BOOST_CHECK_LE(previous_time, time);
+  previous_time = time;
+
+  BOOST_REQUIRE_EQUAL(true, reader.Next(time, line));
+  BOOST_CHECK_EQUAL(long_line, line);
+  BOOST_CHECK_LE(previous_time, time);
+
+  BOOST_CHECK_EQUAL(false, reader.Next(time, line));
+}
+
+BOOST_AUTO_TEST_CASE(capture_and_replay)
+{
+  std::string testData{"cmd1\n"
+                      "{\n"
+                      "cmd2\n"
+                      "cmd3\n"
+                      "}\n"
+                      "cmd4\n"};
+  std::string result{
+    "bulk: cmd1\n"
+    "bulk: cmd2, cmd3\n"
+    "bulk: cmd4\n"
+  };
+
+  {
+    std::istringstream iss(testData);
+    std::ostringstream oss;
+    auto commandProcessor = std::make_unique<CommandProcessor>();
+    auto storage = std::make_shared<Storage>(3);
+    auto consoleOutput = std::make_shared<ConsoleOutput>(oss);
+    storage->Subscribe(consoleOutput);
+    commandProcessor->Subscribe(storage);
+    commandProcessor->Capture(std::make_shared<TraceWriter>(filename));
+
+    commandProcessor->Process(iss);
+    BOOST_CHECK_EQUAL(oss.str(), result);
+  }
+
+  std::ostringstream oss;
+  auto commandProcessor = std::make_unique<CommandProcessor>();
+  auto storage = std::make_shared<Storage>(3);
+  auto consoleOutput = std::make_shared<ConsoleOutput>(oss);
+  storage->Subscribe(consoleOutput);
+  commandProcessor->Subscribe(storage);
+
+  TraceReader reader{filename};
+  while(reader.Next(time, line)) {
+    commandProcessor->ProcessCommand(line);
+  }
+  commandProcessor->Finish();
+
+  BOOST_CHECK_EQUAL(oss.str(), result);
+}
+
+BOOST_AUTO_TEST_CASE(wrong_signature)
+{
+  {
+    std::ofstream ofs{filename.c_str()};
+    ofs << "not a trace";
+  }
+  BOOST_CHECK_THROW(TraceReader{filename}, std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(periodic_flush)
+{
+  TraceWriter writer{filename};
+  writer.Write("cmd1");
+  std::this_thread::sleep_for(std::chrono::milliseconds{150});
+  writer.Write("cmd2");
+
+  // Записи доступны, пока трасса ещё пишется.
+  TraceReader reader{filename};
+  BOOST_REQUIRE_EQUAL(true, reader.Next(time, line));
+  BOOST_CHECK_EQUAL("cmd1", line);
+  BOOST_REQUIRE_EQUAL(true, reader.Next(time, line));
+  BOOST_CHECK_EQUAL("cmd2", line);
+}
+
+BOOST_AUTO_TEST_CASE(flush_on_signal)
+{
+  const int line_count = 3000;
+  auto pid = fork();
+  BOOST_REQUIRE_NE(-1, pid);
+  if(0 == pid) {
+    TraceWriter writer{filename};
+    for(int i = 0; i < line_count; ++i) {
+      writer.Write("cmd" + std::to_string(i));
+    }
+    raise(SIGTERM);
+    _exit(0);
+  }
+  int status;
+  BOOST_REQUIRE_EQUAL(pid, waitpid(pid, &status, 0));
+  BOOST_CHECK(WIFSIGNALED(status));
+
+  TraceReader reader{filename};
+  int count{0};
+  while(reader.Next(time, line)) {
+    BOOST_REQUIRE_EQUAL("cmd" + std::to_string(count), line);
+    ++count;
+  }
+  BOOST_CHECK_EQUAL(line_count, count);
+  BOOST_CHECK_EQUAL(false, reader.IsTruncated());
+}
+
+BOOST_AUTO_TEST_CASE(truncated_last_record)
+{
+  {
+    TraceWriter writer{filename};
+    writer.Write("cmd1");
+    writer.Write("cmd2");
+  }
+  std::ifstream ifs{filename.c_str(), std::ifstream::binary};
+  std::string content{std::istreambuf_iterator<char>{ifs}, std::istreambuf_iterator<char>{}};
+  ifs.close();
+  std::ofstream{filename.c_str(), std::ofstream::binary | std::ofstream::trunc}
+    << content.substr(0, content.size() - 2);
+
+  TraceReader reader{filename};
+  BOOST_REQUIRE_EQUAL(true, reader.Next(time, line));
+  BOOST_CHECK_EQUAL("cmd1", line);
+  BOOST_CHECK_EQUAL(false, reader.Next(time, line));
+  BOOST_CHECK_EQUAL(true, reader.IsTruncated());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,6 +1,7 @@
 #include <sys/file.h>
 #include <sstream>
 #include <deque>
+#include <array>
 #include <algorithm>
 #include "Storage.h"
 #include "FileOutput.h"
@@ -87,7 +88,7 @@ BOOST_AUTO_TEST_CASE(file_output_to_locked_file)
   FileOutput fileOutput;
   std::string result;
   std::string goodResult{"bulk: cmd1, cmd2, cmd3"};
-  std::list<std::string> testData{"cmd1", "cmd2", "cmd3"};
+  Bulk testData{"cmd1", "cmd2", "cmd3"};
   size_t timestamp = 123;
   auto filename = MakeFilename(timestamp);
 
@@ -1,6 +1,7 @@
 #include "Storage.h"
 #include "ConsoleOutput.h"
 #include "FileOutput.h"
+#include "CommandProcessor.h"
 
 #define BOOST_TEST_MODULE test_internal_data_structures
 
@@ -64,4 +65,80 @@ BOOST_AUTO_TEST_CASE(make_filename)
   BOOST_CHECK_EQUAL("bulk123.log", MakeFilename(timestamp));
 }
 
+BOOST_AUTO_TEST_CASE(command_arena)
+{
+  CommandArena arena{16};
+
+  auto command1 = arena.Materialize("cmd1");
+  auto command2 = arena.Materialize("cmd2");
+  auto command3 = arena.Materialize("cmd3_long");
+
+  BOOST_CHECK(command1 == "cmd1");
+  BOOST_CHECK(command2 == "cmd2");
+  BOOST_CHECK(command3 == "cmd3_long");
+  BOOST_CHECK_EQUAL(command1.data() + command1.size(), command2.data());
+  BOOST_CHECK_NE(command2.data() + command2.size(), command3.data());
+}
+
+BOOST_AUTO_TEST_CASE(commands_shared_between_storages)
+{
+  class TestOutput : public IOutput
+  {
+  public:
+    const char* Name() const override {
+      return "TestOutput";
+    }
+
+    void Output(const std::size_t, const Bulk& data) override {
+      for(const auto& command : data) {
+        commands.push_back(command.data());
+      }
+    }
+    std::vector<const char*> commands;
+  };
+
+  std::istringstream iss{"cmd1\ncmd2\ncmd3\n"};
+  auto commandProcessor = std::make_unique<CommandProcessor>();
+  auto storage1 = std::make_shared<Storage>(1);
+  auto storage2 = std::make_shared<Storage>(3);
+  auto output1 = std::make_shared<TestOutput>();
+  auto output2 = std::make_shared<TestOutput>();
+
+  storage1->Subscribe(output1);
+  storage2->Subscribe(output2);
+  commandProcessor->Subscribe(storage1);
+  commandProcessor->Subscribe(storage2);
+
+  commandProcessor->Process(iss);
+
+  BOOST_REQUIRE_EQUAL(3, output1->commands.size());
+  BOOST_CHECK(output1->commands == output2->commands);
+}
+
+BOOST_AUTO_TEST_CASE(processors_share_thread_arena)
+{
+  class TestStorage : public Storage
+  {
+  public:
+    TestStorage() : Storage{1} {}
+    void Push(const Command& command) override {
+      commands.push_back(command);
+    }
+    std::vector<Command> commands;
+  };
+
+  auto storage = std::make_shared<TestStorage>();
+  CommandProcessor commandProcessor1;
+  CommandProcessor commandProcessor2;
+  commandProcessor1.Subscribe(storage);
+  commandProcessor2.Subscribe(storage);
+
+  commandProcessor1.ProcessCommand("cmd1");
+  commandProcessor2.ProcessCommand("cmd2");
+
+  BOOST_REQUIRE_EQUAL(2, storage->commands.size());
+  BOOST_CHECK_EQUAL(storage->commands[0].data() + storage->commands[0].size(),
+                    storage->commands[1].data());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,118 @@
+#include <fstream>
+#include <random>
+#include <sstream>
+#include "Storage.h"
+#include "JsonOutput.h"
+#include "CommandProcessor.h"
+
+#define BOOST_TEST_MODULE test_json_output
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+
+template<typename Escape>
+std::string EscapeWith(Escape escape, const std::string& data) {
+  std::string result(JsonEscapedMaxSize(data.size()), '\0');
+  result.resize(escape(&result[0], data.data(), data.size()) - result.data());
+  return result;
+}
+
+BOOST_AUTO_TEST_SUITE(test_suite_main)
+
+BOOST_AUTO_TEST_CASE(escape_special_symbols)
+{
+  std::string data{"a\"b\\c\b\f\n\r\t\x01\x1f d\xd0\xb9"};
+  std::string result{"a\\\"b\\\\c\\b\\f\\n\\r\\t\\u0001\\u001f d\xd0\xb9"};
+
+  BOOST_CHECK_EQUAL(result, EscapeWith(WriteJsonEscaped, data));
+  BOOST_CHECK_EQUAL(result, EscapeWith(WriteJsonEscapedScalar, data));
+}
+
+BOOST_AUTO_TEST_CASE(vectorized_escape_matches_scalar)
+{
+  std::mt19937 generator{42};
+  const char alphabet[] = "abcdefgh \"\\\n\t\x01\x7f\x80\xff";
+  std::uniform_int_distribution<std::size_t> symbol{0, sizeof(alphabet) - 2};
+  std::uniform_int_distribution<int> percent{0, 99};
+
+  for(std::size_t size = 0; size < 400; ++size) {
+    // Доля экранируемых байтов от редкой до сплошной.
+    auto density = static_cast<int>(size % 4 * 33);
+    std::string data;
+    for(std::size_t i = 0; i < size; ++i) {
+      data += percent(generator) < density ? alphabet[symbol(generator)] : 'x';
+    }
+    auto scalar = EscapeWith(WriteJsonEscapedScalar, data);
+    BOOST_REQUIRE_EQUAL(scalar, EscapeWith(WriteJsonEscaped, data));
+#ifdef BULK_JSON_ESCAPE_X86
+    BOOST_REQUIRE_EQUAL(scalar, EscapeWith(WriteJsonEscapedSse2, data));
+    if(__builtin_cpu_supports("avx2")) {
+      BOOST_REQUIRE_EQUAL(scalar, EscapeWith(WriteJsonEscapedAvx2, data));
+    }
+#endif
+  }
+}
+
+BOOST_AUTO_TEST_CASE(json_lines_records)
+{
+  std::istringstream iss{"cmd1\n"
+                         "cmd\"2\n"
+                         "{\n"
+                         "cmd3\n"
+                         "\n"
+                         "}\n"};
+  std::ostringstream oss;
+  auto commandProcessor = std::make_unique<CommandProcessor>();
+  auto storage = std::make_shared<Storage>(3);
+  auto jsonOutput = std::make_shared<JsonOutput>(oss);
+  storage->Subscribe(jsonOutput);
+  commandProcessor->Subscribe(storage);
+
+  commandProcessor->Process(iss);
+
+  std::istringstream result{oss.str()};
+  std::string line;
+  std::getline(result, line);
+  BOOST_CHECK_EQUAL(0, line.find("{\"ts\":"));
+  BOOST_CHECK_NE(std::string::npos, line.find(",\"dynamic\":false,\"cmds\":[\"cmd1\",\"cmd\\\"2\"]}"));
+  std::getline(result, line);
+  BOOST_CHECK_NE(std::string::npos, line.find(",\"dynamic\":true,\"cmds\":[\"cmd3\",\"\"]}"));
+  BOOST_CHECK_EQUAL(false, static_cast<bool>(std::getline(result, line)));
+}
+
+BOOST_AUTO_TEST_CASE(output_without_kind)
+{
+  std::ostringstream oss;
+  JsonOutput jsonOutput{oss};
+
+  jsonOutput.Output(123, {"cmd1"});
+  BOOST_CHECK_EQUAL("{\"ts\":123,\"dynamic\":false,\"cmds\":[\"cmd1\"]}\n", oss.str());
+}
+
+BOOST_AUTO_TEST_CASE(write_to_failed_stream)
+{
+  std::ofstream ofs;
+  JsonOutput jsonOutput{ofs};
+
+  BOOST_CHECK_THROW(jsonOutput.Output(123, {"cmd1"}), std::runtime_error);
+  BOOST_CHECK_THROW(jsonOutput.Output(124, {"cmd2"}), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(record_flushed_to_file)
+{
+  std::string filename{"test_json_output.jsonl"};
+  std::ofstream ofs{filename.c_str(), std::ofstream::out | std::ofstream::trunc};
+  JsonOutput jsonOutput{ofs};
+
+  jsonOutput.Output(123, {"cmd1"});
+
+  // Файл читается, пока поток ещё открыт.
+  std::ifstream ifs{filename.c_str()};
+  std::string line;
+  std::getline(ifs, line);
+  BOOST_CHECK_EQUAL("{\"ts\":123,\"dynamic\":false,\"cmds\":[\"cmd1\"]}", line);
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,196 @@
+#include <sys/wait.h>
+#include <unistd.h>
+#include "SharedMemoryOutput.h"
+#include "SharedMemoryReader.h"
+
+#define BOOST_TEST_MODULE test_shared_memory_output
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+
+struct shared_memory_ring
+{
+  shared_memory_ring()
+    : name{"/bulk_test_" + std::to_string(getpid())} {}
+
+  std::string name;
+  std::size_t timestamp;
+  std::string bulk;
+};
+
+BOOST_FIXTURE_TEST_SUITE(test_suite_main, shared_memory_ring)
+
+BOOST_AUTO_TEST_CASE(read_published_bulks)
+{
+  SharedMemoryOutput output{name, 4, 64};
+  SharedMemoryReader reader{name};
+
+  BOOST_CHECK_EQUAL(false, reader.TryRead(timestamp, bulk));
+
+  output.Output(123, {"cmd1", "cmd2", "cmd3"});
+  output.Output(456, {"cmd4"});
+
+  BOOST_REQUIRE_EQUAL(true, reader.TryRead(timestamp, bulk));
+  BOOST_CHECK_EQUAL(123, timestamp);
+  BOOST_CHECK_EQUAL("bulk: cmd1, cmd2, cmd3\n", bulk);
+
+  BOOST_REQUIRE_EQUAL(true, reader.TryRead(timestamp, bulk));
+  BOOST_CHECK_EQUAL(456, timestamp);
+  BOOST_CHECK_EQUAL("bulk: cmd4\n", bulk);
+
+  BOOST_CHECK_EQUAL(false, reader.TryRead(timestamp, bulk));
+  BOOST_CHECK_EQUAL(0, reader.GetLostCount());
+}
+
+BOOST_AUTO_TEST_CASE(multiple_readers)
+{
+  SharedMemoryOutput output{name, 4, 64};
+  SharedMemoryReader reader1{name};
+  SharedMemoryReader reader2{name};
+
+  output.Output(1, {"cmd1"});
+
+  BOOST_REQUIRE_EQUAL(true, reader1.TryRead(timestamp, bulk));
+  BOOST_CHECK_EQUAL("bulk: cmd1\n", bulk);
+  BOOST_REQUIRE_EQUAL(true, reader2.TryRead(timestamp, bulk));
+  BOOST_CHECK_EQUAL("bulk: cmd1\n", bulk);
+}
+
+BOOST_AUTO_TEST_CASE(overrun_skip_to_oldest)
+{
+  SharedMemoryOutput output{name, 4, 64};
+  SharedMemoryReader reader{name, SharedMemoryReader::OverrunPolicy::SkipToOldest};
+
+  for(std::size_t i = 0; i < 10; ++i) {
+    output.Output(i, {"cmd" + std::to_string(i)});
+  }
+
+  BOOST_REQUIRE_EQUAL(true, reader.TryRead(timestamp, bulk));
+  BOOST_CHECK_EQUAL(7, timestamp);
+  BOOST_CHECK_EQUAL(7, reader.GetLostCount());
+}
+
+BOOST_AUTO_TEST_CASE(overrun_skip_to_newest)
+{
+  SharedMemoryOutput output{name, 4, 64};
+  SharedMemoryReader reader{name, SharedMemoryReader::OverrunPolicy::SkipToNewest};
+
+  for(std::size_t i = 0; i < 10; ++i) {
+    output.Output(i, {"cmd" + std::to_string(i)});
+  }
+
+  BOOST_CHECK_EQUAL(false, reader.TryRead(timestamp, bulk));
+  BOOST_CHECK_EQUAL(10, reader.GetLostCount());
+
+  output.Output(10, {"cmd10"});
+  BOOST_REQUIRE_EQUAL(true, reader.TryRead(timestamp, bulk));
+  BOOST_CHECK_EQUAL(10, timestamp);
+}
+
+BOOST_AUTO_TEST_CASE(overrun_throw)
+{
+  SharedMemoryOutput output{name, 4, 64};
+  SharedMemoryReader reader{name, SharedMemoryReader::OverrunPolicy::Throw};
+
+  for(std::size_t i = 0; i < 10; ++i) {
+    output.Output(i, {"cmd" + std::to_string(i)});
+  }
+
+  BOOST_CHECK_THROW(reader.TryRead(timestamp, bulk), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(bulk_larger_than_slot)
+{
+  SharedMemoryOutput output{name, 4, 16};
+  SharedMemoryReader reader{name};
+
+  output.Output(1, {"cmd1", "cmd2", "cmd3"});
+  output.Output(2, {"cmd12345"});
+
+  BOOST_REQUIRE_EQUAL(true, reader.TryRead(timestamp, bulk));
+  BOOST_CHECK_EQUAL(1, timestamp);
+  BOOST_CHECK_EQUAL("bulk: cmd1, cmd2, cmd3\n", bulk);
+  BOOST_REQUIRE_EQUAL(true, reader.TryRead(timestamp, bulk));
+  BOOST_CHECK_EQUAL(2, timestamp);
+  BOOST_CHECK_EQUAL("bulk: cmd12345\n", bulk);
+  BOOST_CHECK_EQUAL(false, reader.TryRead(timestamp, bulk));
+  BOOST_CHECK_EQUAL(3, reader.GetNextSequence());
+  BOOST_CHECK_EQUAL(0, reader.GetLostCount());
+}
+
+BOOST_AUTO_TEST_CASE(bulk_larger_than_ring)
+{
+  SharedMemoryOutput output{name, 2, 8};
+  SharedMemoryReader reader{name};
+
+  output.Output(1, {"cmd1", "cmd2", "cmd3"});
+
+  BOOST_REQUIRE_EQUAL(true, reader.TryRead(timestamp, bulk));
+  BOOST_CHECK_EQUAL("bulk: cmd1, cmd2", bulk);
+  BOOST_CHECK_EQUAL(1, reader.GetTruncatedCount());
+}
+
+BOOST_AUTO_TEST_CASE(overrun_inside_large_bulk)
+{
+  SharedMemoryOutput output{name, 4, 8};
+  SharedMemoryReader reader{name, SharedMemoryReader::OverrunPolicy::SkipToOldest};
+
+  // Блоки по 2 слота, самый старый блок, который можно читать, начинается с продолжения.
+  output.Output(1, {"cmd1"});
+  output.Output(2, {"cmd2"});
+  output.Output(3, {"cmd3"});
+
+  BOOST_REQUIRE_EQUAL(true, reader.TryRead(timestamp, bulk));
+  BOOST_CHECK_EQUAL(3, timestamp);
+  BOOST_CHECK_EQUAL("bulk: cmd3\n", bulk);
+  BOOST_CHECK_EQUAL(4, reader.GetLostCount());
+}
+
+BOOST_AUTO_TEST_CASE(refuse_segment_of_running_producer)
+{
+  SharedMemoryOutput output{name, 4, 64};
+  SharedMemoryReader reader{name};
+
+  BOOST_CHECK_THROW((SharedMemoryOutput{name, 4, 64}), std::runtime_error);
+
+  // Сегмент работающего производителя не изменён и не удалён.
+  output.Output(1, {"cmd1"});
+  BOOST_REQUIRE_EQUAL(true, reader.TryRead(timestamp, bulk));
+  BOOST_CHECK_EQUAL("bulk: cmd1\n", bulk);
+  BOOST_CHECK_NO_THROW(SharedMemoryReader{name});
+}
+
+BOOST_AUTO_TEST_CASE(producer_closed)
+{
+  auto output = std::make_unique<SharedMemoryOutput>(name, 4, 64);
+  SharedMemoryReader reader{name};
+  BOOST_CHECK_EQUAL(true, reader.IsProducerAlive());
+
+  output.reset();
+  BOOST_CHECK_EQUAL(false, reader.IsProducerAlive());
+  BOOST_CHECK_NO_THROW((SharedMemoryOutput{name, 4, 64}));
+}
+
+BOOST_AUTO_TEST_CASE(replace_segment_of_exited_producer)
+{
+  // Производитель завершается без деструктора и оставляет сегмент.
+  auto pid = fork();
+  BOOST_REQUIRE_NE(-1, pid);
+  if(0 == pid) {
+    new SharedMemoryOutput{name, 4, 64};
+    _exit(0);
+  }
+  int status;
+  BOOST_REQUIRE_EQUAL(pid, waitpid(pid, &status, 0));
+  {
+    SharedMemoryReader reader{name};
+    BOOST_CHECK_EQUAL(false, reader.IsProducerAlive());
+  }
+
+  SharedMemoryOutput output{name, 4, 64};
+  SharedMemoryReader reader{name};
+  BOOST_CHECK_EQUAL(true, reader.IsProducerAlive());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,105 @@
+#include <sstream>
+#include <thread>
+#include "Storage.h"
+#include "FileOutput.h"
+#include "SynchronizedOutput.h"
+#include "CommandProcessor.h"
+
+#define BOOST_TEST_MODULE test_tracer
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+
+std::size_t CountEvents(const std::string& trace, const std::string& name) {
+  std::size_t result{0};
+  auto pattern = "\"name\":\"" + name + "\"";
+  for(auto pos = trace.find(pattern); std::string::npos != pos; pos = trace.find(pattern, pos + 1)) {
+    ++result;
+  }
+  return result;
+}
+
+BOOST_AUTO_TEST_SUITE(test_suite_main)
+
+BOOST_AUTO_TEST_CASE(disabled_tracer_records_nothing)
+{
+  Tracer::Instance().Enable();
+  Tracer::Instance().Disable();
+  {
+    TRACE_SPAN(span, "span", 0);
+  }
+  std::ostringstream oss;
+  Tracer::Instance().Dump(oss);
+
+  BOOST_CHECK_EQUAL(0, CountEvents(oss.str(), "span"));
+}
+
+BOOST_AUTO_TEST_CASE(trace_pipeline_stages)
+{
+  std::istringstream iss{"cmd1\ncmd2\ncmd3\ncmd4\n"};
+  auto commandProcessor = std::make_unique<CommandProcessor>();
+  auto storage = std::make_shared<Storage>(2);
+  auto fileOutput = std::make_shared<FileOutput>();
+  storage->Subscribe(fileOutput);
+  commandProcessor->Subscribe(storage);
+
+  Tracer::Instance().Enable();
+  commandProcessor->Process(iss);
+  Tracer::Instance().Disable();
+
+  std::ostringstream oss;
+  Tracer::Instance().Dump(oss);
+  auto trace = oss.str();
+
+  BOOST_CHECK_EQUAL(0, trace.find("{\"traceEvents\":["));
+  BOOST_CHECK_EQUAL(5, CountEvents(trace, "ReadLine"));
+  BOOST_CHECK_EQUAL(4, CountEvents(trace, "Storage::Push"));
+  BOOST_CHECK_EQUAL(2, CountEvents(trace, "Storage::Flush"));
+  BOOST_CHECK_EQUAL(2, CountEvents(trace, "FileOutput"));
+  BOOST_CHECK_EQUAL(2, CountEvents(trace, "FileOutput::Open"));
+  BOOST_CHECK_EQUAL(2, CountEvents(trace, "FileOutput::Write"));
+  BOOST_CHECK_EQUAL(2, CountEvents(trace, "FileOutput::Close"));
+
+  // Все интервалы вывода блока помечены его меткой времени.
+  auto open_pos = trace.find("FileOutput::Open");
+  auto bulk_pos = trace.find("\"bulk\":", open_pos);
+  BOOST_REQUIRE_NE(std::string::npos, bulk_pos);
+  auto timestamp = trace.substr(bulk_pos + 7, trace.find('}', bulk_pos) - bulk_pos - 7);
+  std::ifstream ifs{MakeFilename(std::stoull(timestamp)).c_str()};
+  BOOST_CHECK_EQUAL(false, ifs.fail());
+
+  for(auto pos = trace.find("\"bulk\":"); std::string::npos != pos; pos = trace.find("\"bulk\":", pos + 1)) {
+    auto value = trace.substr(pos + 7, trace.find('}', pos) - pos - 7);
+    std::remove(MakeFilename(std::stoull(value)).c_str());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ring_buffer_keeps_last_spans)
+{
+  Tracer::Instance().Enable(4);
+  std::thread thread{[] {
+    for(std::uint64_t i = 0; i < 10; ++i) {
+      TRACE_SPAN(span, "thread_span", i);
+    }
+  }};
+  thread.join();
+  Tracer::Instance().Disable();
+
+  std::ostringstream oss;
+  Tracer::Instance().Dump(oss);
+  auto trace = oss.str();
+
+  BOOST_CHECK_EQUAL(4, CountEvents(trace, "thread_span"));
+  BOOST_CHECK_EQUAL(std::string::npos, trace.find("\"bulk\":5}"));
+  BOOST_CHECK_NE(std::string::npos, trace.find("\"bulk\":6}"));
+  BOOST_CHECK_NE(std::string::npos, trace.find("\"bulk\":9}"));
+}
+
+BOOST_AUTO_TEST_CASE(synchronized_output_keeps_sink_name)
+{
+  SynchronizedOutput synchronizedOutput{std::make_shared<FileOutput>()};
+  BOOST_CHECK_EQUAL(std::string{"FileOutput"}, synchronizedOutput.Name());
+}
+
+BOOST_AUTO_TEST_SUITE_END()